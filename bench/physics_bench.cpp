@@ -0,0 +1,540 @@
+//
+//  physics_bench.cpp rbashkort 16/10/2026
+//
+//  Micro benchmarks of the physics kernels in isolation: no window, no GL,
+//  no ECS world. Shapes are random but seeded, so runs are comparable.
+//  Writes one JSON object (ns/op and pairs/sec per kernel) to stdout or --out.
+//
+//  physics_bench [--seed N] [--pairs N] [--bodies N] [--time ms] [--out file]
+//
+
+#include "physics.hpp"
+#include "broadphase.h"
+#include "physics_simd.h"
+#include "shape_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Options {
+    uint32_t seed = 1234;
+    uint32_t pairs = 4096;      // narrowphase pairs per run
+    uint32_t bodies = 10000;    // broadphase bodies
+    double minTime = 0.25;      // s per benchmark
+    const char* out = nullptr;
+};
+
+struct Result {
+    std::string name;
+    uint64_t opsPerRun;
+    uint64_t runs;
+    double nsPerOp;
+    double pairsPerSec;         // pairs tested (narrowphase) or found (broadphase), 0 if none
+    uint64_t hits;              // per run, also keeps the work alive
+};
+
+static std::vector<Result> results;
+static Options options;
+
+// Runs f() until minTime has passed. f returns its hit count, pairsPerRun < 0
+// means the hits are the pairs (pair searches)
+template<typename F>
+static void measure(const char* name, uint64_t opsPerRun, int64_t pairsPerRun, F&& f) {
+    uint64_t hits = f(); // warm up, caches and lazily grown buffers
+    uint64_t runs = 0;
+    double elapsed = 0.0;
+    Clock::time_point start = Clock::now();
+    do {
+        hits = f();
+        ++runs;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < options.minTime);
+
+    double pairs = pairsPerRun < 0 ? (double)hits : (double)pairsPerRun;
+    Result r;
+    r.name = name;
+    r.opsPerRun = opsPerRun;
+    r.runs = runs;
+    r.nsPerOp = opsPerRun ? elapsed * 1e9 / ((double)runs * (double)opsPerRun) : 0.0;
+    r.pairsPerSec = pairs * (double)runs / elapsed;
+    r.hits = hits;
+    results.push_back(r);
+    fprintf(stderr, "%-24s %10.2f ns/op %14.0f pairs/s\n", name, r.nsPerOp, r.pairsPerSec);
+}
+
+// ================= Shape data =================
+
+struct ShapeSample {
+    E_Transform t;
+    E_Collider c;
+};
+
+static ShapeSample randomShape(std::mt19937& rng, ColliderType type, float x, float y) {
+    std::uniform_real_distribution<float> size(8.0f, 40.0f), angle(0.0f, 360.0f);
+    ShapeSample s;
+    s.t.x = x;
+    s.t.y = y;
+    s.t.angle = angle(rng);
+    s.c.type = type;
+    s.c.width = size(rng);
+    s.c.height = size(rng);
+    s.c.radius = size(rng) * 0.5f;
+    return s;
+}
+
+// B placed around A so that about half of the pairs overlap
+static void randomPairs(std::mt19937& rng, ColliderType typeA, ColliderType typeB, uint32_t count,
+                        std::vector<ShapeSample>& a, std::vector<ShapeSample>& b) {
+    std::uniform_real_distribution<float> pos(0.0f, 2000.0f), offset(-28.0f, 28.0f);
+    a.clear();
+    b.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        float x = pos(rng), y = pos(rng);
+        a.push_back(randomShape(rng, typeA, x, y));
+        b.push_back(randomShape(rng, typeB, x + offset(rng), y + offset(rng)));
+    }
+}
+
+static ColliderType polyType(std::mt19937& rng) {
+    return rng() & 1 ? ColliderType::Rect : ColliderType::Triangle;
+}
+
+// ================= Narrowphase =================
+
+static void benchNarrowphase(std::mt19937& rng) {
+    const uint32_t n = options.pairs;
+    std::vector<ShapeSample> a, b;
+    std::vector<PolyVerts> va(n), vb(n);
+
+    // getVertices
+    randomPairs(rng, ColliderType::Rect, ColliderType::Triangle, n, a, b);
+    for (uint32_t i = 0; i < n; ++i) a[i].c.type = polyType(rng);
+    measure("getVertices", n, 0, [&]() {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            va[i] = getVertices(a[i].t, a[i].c);
+            sum += va[i].count;
+        }
+        return sum;
+    });
+
+    // satPolyPoly, rects and triangles mixed
+    for (uint32_t i = 0; i < n; ++i) {
+        b[i].c.type = polyType(rng);
+        va[i] = getVertices(a[i].t, a[i].c);
+        vb[i] = getVertices(b[i].t, b[i].c);
+    }
+    measure("satPolyPoly", n, n, [&]() {
+        uint64_t hits = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            Vec2 mtv = {0, 0};
+            hits += satPolyPoly(va[i].data, va[i].count, vb[i].data, vb[i].count, mtv);
+        }
+        return hits;
+    });
+
+    // satCirclePoly
+    randomPairs(rng, ColliderType::Circle, ColliderType::Rect, n, a, b);
+    for (uint32_t i = 0; i < n; ++i) {
+        b[i].c.type = polyType(rng);
+        vb[i] = getVertices(b[i].t, b[i].c);
+    }
+    measure("satCirclePoly", n, n, [&]() {
+        uint64_t hits = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            Vec2 mtv = {0, 0};
+            hits += satCirclePoly({a[i].t.x, a[i].t.y}, a[i].c.radius, vb[i].data, vb[i].count, mtv);
+        }
+        return hits;
+    });
+
+    // satCircleCircle
+    randomPairs(rng, ColliderType::Circle, ColliderType::Circle, n, a, b);
+    measure("satCircleCircle", n, n, [&]() {
+        uint64_t hits = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            Vec2 mtv = {0, 0};
+            hits += satCircleCircle({a[i].t.x, a[i].t.y}, a[i].c.radius, {b[i].t.x, b[i].t.y}, b[i].c.radius, mtv);
+        }
+        return hits;
+    });
+
+    // what the engine runs: cached world shapes, SAT and GJK
+    std::vector<WorldShape> sa(n), sb(n);
+    randomPairs(rng, ColliderType::Rect, ColliderType::Rect, n, a, b);
+    for (uint32_t i = 0; i < n; ++i) {
+        a[i].c.type = polyType(rng);
+        b[i].c.type = polyType(rng);
+    }
+    measure("computeWorldShape", n, 0, [&]() {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            computeWorldShape(a[i].t, a[i].c, sa[i]);
+            sum += sa[i].count;
+        }
+        return sum;
+    });
+    for (uint32_t i = 0; i < n; ++i) computeWorldShape(b[i].t, b[i].c, sb[i]);
+    measure("satShapeShape", n, n, [&]() {
+        uint64_t hits = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            Vec2 mtv = {0, 0};
+            hits += satShapeShape(sa[i], sb[i], mtv);
+        }
+        return hits;
+    });
+
+    // pool polygons (octagons) through GJK/EPA
+    float octagon[16];
+    for (int k = 0; k < 8; ++k) {
+        octagon[2 * k] = 20.0f * cosf(k * 0.785398f);
+        octagon[2 * k + 1] = 20.0f * sinf(k * 0.785398f);
+    }
+    const uint32_t polygon = createPolygon(octagon, 8);
+    for (uint32_t i = 0; i < n; ++i) {
+        a[i].c.type = ColliderType::Polygon;
+        a[i].c.polygon = polygon;
+        computeWorldShape(a[i].t, a[i].c, sa[i]);
+    }
+    measure("gjkShapeShape", n, n, [&]() {
+        uint64_t hits = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            Vec2 mtv = {0, 0};
+            hits += gjkShapeShape(sa[i], sb[i], mtv);
+        }
+        return hits;
+    });
+}
+
+// ================= Batched kernels =================
+
+static void benchBatches(std::mt19937& rng) {
+    std::unique_ptr<ShapeBatch> batch = std::make_unique<ShapeBatch>();
+    std::uniform_real_distribution<float> pos(0.0f, 2000.0f), offset(-28.0f, 28.0f), size(4.0f, 20.0f);
+
+    struct Kernel {
+        const char* name;
+        void (*run)(ShapeBatch&);
+        bool circleA, circleB;
+    };
+    const Kernel kernels[] = {
+        {"batchCircleCircle", batchCircleCircle, true, true},
+        {"batchBoxBox", batchBoxBox, false, false},
+        {"batchCircleBox", batchCircleBox, true, false},
+    };
+
+    for (const Kernel& k : kernels) {
+        batch->clear();
+        while (!batch->full()) {
+            float x = pos(rng), y = pos(rng);
+            float rA = size(rng);
+            float rB = size(rng);
+            batch->push(x, y, rA, k.circleA ? 0.0f : size(rng),
+                        x + offset(rng), y + offset(rng), rB, k.circleB ? 0.0f : size(rng));
+        }
+        measure(k.name, SHAPE_BATCH_SIZE, SHAPE_BATCH_SIZE, [&]() {
+            k.run(*batch);
+            uint64_t hits = 0;
+            for (uint32_t i = 0; i < batch->count; ++i) hits += batch->hit[i];
+            return hits;
+        });
+    }
+}
+
+// ================= Broadphase =================
+
+static void benchBroadphase(std::mt19937& rng) {
+    const uint32_t n = options.bodies;
+    const float cellSize = 128.0f;
+
+    // ~20 bodies per 128x128 cell at 10k bodies, sizes like the demo scenes
+    const float extent = sqrtf((float)n / 20.0f) * cellSize;
+    std::uniform_real_distribution<float> pos(0.0f, extent), size(4.0f, 24.0f), step(-2.0f, 2.0f);
+    std::vector<Aabb> boxes(n);
+    for (Aabb& box : boxes) {
+        float x = pos(rng), y = pos(rng), r = size(rng);
+        box = {x - r, y - r, x + r, y + r};
+    }
+
+    // flat grid: binning + counting sort, then the engine's in-cell pair search
+    // (a pair is reported by the cell holding the min corner of the overlap)
+    FlatGrid grid;
+    auto buildGrid = [&]() {
+        grid.clear();
+        for (uint32_t i = 0; i < n; ++i) {
+            const Aabb& box = boxes[i];
+            for (int x = (int)floorf(box.minX / cellSize); x <= (int)floorf(box.maxX / cellSize); ++x)
+            for (int y = (int)floorf(box.minY / cellSize); y <= (int)floorf(box.maxY / cellSize); ++y) {
+                grid.insert(hashCellGlobal(x, y), i);
+            }
+        }
+        grid.build();
+        return (uint64_t)grid.entryCount();
+    };
+    measure("grid_build", n, 0, buildGrid);
+
+    buildGrid();
+    measure("grid_pairs", n, -1, [&]() {
+        uint64_t pairs = 0;
+        for (uint32_t c = 0; c < grid.cellCount(); ++c) {
+            FlatGrid::Cell cell = grid.cellAt(c);
+            const int cellX = cellKeyX(grid.keyAt(c));
+            const int cellY = cellKeyY(grid.keyAt(c));
+            for (uint32_t p = 0; p < cell.count; ++p)
+            for (uint32_t q = p + 1; q < cell.count; ++q) {
+                const Aabb& a = boxes[cell.data[p]];
+                const Aabb& b = boxes[cell.data[q]];
+                if (!a.overlaps(b)) continue;
+                float ox = a.minX > b.minX ? a.minX : b.minX;
+                float oy = a.minY > b.minY ? a.minY : b.minY;
+                if ((int)floorf(ox / cellSize) != cellX || (int)floorf(oy / cellSize) != cellY) continue;
+                ++pairs;
+            }
+        }
+        return pairs;
+    });
+
+    // walkBox of the engine: the cells under the box, a box test, and the
+    // ownership rule so a body spanning several of them is reported once
+    measure("grid_query", n, 0, [&]() {
+        uint64_t found = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            const Aabb& query = boxes[i];
+            const int cMinX = (int)floorf(query.minX / cellSize), cMaxX = (int)floorf(query.maxX / cellSize);
+            const int cMinY = (int)floorf(query.minY / cellSize), cMaxY = (int)floorf(query.maxY / cellSize);
+            for (int x = cMinX; x <= cMaxX; ++x)
+            for (int y = cMinY; y <= cMaxY; ++y) {
+                for (uint32_t j : grid.cell(hashCellGlobal(x, y))) {
+                    const Aabb& b = boxes[j];
+                    if (!b.overlaps(query)) continue;
+                    float ox = b.minX > query.minX ? b.minX : query.minX;
+                    float oy = b.minY > query.minY ? b.minY : query.minY;
+                    if ((int)floorf(ox / cellSize) != x || (int)floorf(oy / cellSize) != y) continue;
+                    ++found;
+                }
+            }
+        }
+        return found;
+    });
+
+    // moving bodies: every run shifts the boxes a little, like a frame. The
+    // frames are made up front, the update timings hold no RNG cost
+    const int frameCount = 16;
+    std::vector<std::vector<Aabb>> frames(frameCount, std::vector<Aabb>(n));
+    for (std::vector<Aabb>& frame : frames) {
+        for (uint32_t i = 0; i < n; ++i) {
+            float dx = step(rng), dy = step(rng);
+            frame[i] = {boxes[i].minX + dx, boxes[i].minY + dy, boxes[i].maxX + dx, boxes[i].maxY + dy};
+        }
+    }
+    int frame = 0;
+    const std::vector<Aabb>* moved = &frames[0];
+    auto nextFrame = [&]() {
+        moved = &frames[frame];
+        frame = (frame + 1) % frameCount;
+    };
+
+    SweepAndPrune sap;
+    measure("sap_update", n, 0, [&]() {
+        nextFrame();
+        sap.beginFrame();
+        for (uint32_t i = 0; i < n; ++i) sap.update(i + 1, (*moved)[i], i);
+        sap.endFrame();
+        return (uint64_t)sap.proxyCount();
+    });
+    measure("sap_pairs", n, -1, [&]() {
+        uint64_t pairs = 0;
+        sap.findPairs([&](uint32_t, uint32_t) { ++pairs; });
+        return pairs;
+    });
+    measure("sap_query", n, 0, [&]() {
+        uint64_t found = 0;
+        for (uint32_t i = 0; i < n; ++i) sap.query((*moved)[i], [&](uint32_t) { ++found; });
+        return found;
+    });
+
+    AabbTree tree;
+    measure("aabbtree_update", n, 0, [&]() {
+        nextFrame();
+        uint64_t reinserted = 0;
+        tree.beginFrame();
+        for (uint32_t i = 0; i < n; ++i) reinserted += tree.update(i + 1, (*moved)[i], i);
+        tree.endFrame();
+        return reinserted;
+    });
+    measure("aabbtree_pairs", n, -1, [&]() {
+        uint64_t pairs = 0;
+        tree.findPairs([&](uint32_t, uint32_t) { ++pairs; });
+        return pairs;
+    });
+    // fat leaf boxes, the real box test like walkBox
+    measure("aabbtree_query", n, 0, [&]() {
+        uint64_t found = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            const Aabb& query = (*moved)[i];
+            tree.query(query, [&](uint32_t j) { found += (*moved)[j].overlaps(query); });
+        }
+        return found;
+    });
+}
+
+// ================= Pair dedup =================
+
+// The 250-circle SceneMenu scaled to 50k bodies at the same density (area x200):
+// radius 5, velocity +-20, dt 1/60, one thread. The hash set of every pair
+// that shares a cell (the grid pass before the ownership rule) against the
+// min-corner ownership. Both on the same grid, the build is not timed
+static void benchPairDedup(std::mt19937& rng) {
+    const uint32_t n = 50000;
+    const float scale = sqrtf((float)n / 250.0f);
+    const float cellSize = 128.0f, r = 5.0f, dt = 1.0f / 60.0f;
+    std::uniform_real_distribution<float> posX(0.0f, 1024.0f * scale), posY(0.0f, 768.0f * scale), v(-20.0f, 20.0f);
+
+    // swept boxes like ECSWorld::gatherBodies
+    std::vector<Aabb> boxes(n);
+    for (Aabb& box : boxes) {
+        float x = posX(rng), y = posY(rng), vx = v(rng) * dt, vy = v(rng) * dt;
+        box = {x - r - std::fmax(0.0f, vx), y - r - std::fmax(0.0f, vy),
+               x + r - std::fmin(0.0f, vx), y + r - std::fmin(0.0f, vy)};
+    }
+
+    FlatGrid grid;
+    for (uint32_t i = 0; i < n; ++i) {
+        const Aabb& box = boxes[i];
+        for (int x = (int)floorf(box.minX / cellSize); x <= (int)floorf(box.maxX / cellSize); ++x)
+        for (int y = (int)floorf(box.minY / cellSize); y <= (int)floorf(box.maxY / cellSize); ++y) {
+            grid.insert(hashCellGlobal(x, y), i);
+        }
+    }
+    grid.build();
+
+    struct PairHash {
+        size_t operator()(uint64_t key) const noexcept {
+            uint64_t h1 = key >> 32, h2 = key & 0xFFFFFFFFu;
+            return (size_t)(h1 ^ (h2 + 0x9e3779b97f4a7c15ull + (h1 << 6) + (h1 >> 2)));
+        }
+    };
+    std::unordered_set<uint64_t, PairHash> tested;
+    uint64_t inserts = 0;
+    measure("menu50k_hashset_pairs", n, -1, [&]() {
+        tested.clear();
+        inserts = 0;
+        uint64_t pairs = 0;
+        for (uint32_t c = 0; c < grid.cellCount(); ++c) {
+            FlatGrid::Cell cell = grid.cellAt(c);
+            for (uint32_t p = 0; p < cell.count; ++p)
+            for (uint32_t q = 0; q < cell.count; ++q) {
+                if (p == q) continue;
+                uint32_t a = cell.data[p], b = cell.data[q];
+                if (a > b) std::swap(a, b);
+                ++inserts;
+                pairs += tested.insert((uint64_t)a << 32 | b).second;
+            }
+        }
+        return pairs;
+    });
+    fprintf(stderr, "%-24s %10llu hash inserts\n", "", (unsigned long long)inserts);
+
+    measure("menu50k_owner_pairs", n, -1, [&]() {
+        uint64_t pairs = 0;
+        for (uint32_t c = 0; c < grid.cellCount(); ++c) {
+            FlatGrid::Cell cell = grid.cellAt(c);
+            const int cellX = cellKeyX(grid.keyAt(c));
+            const int cellY = cellKeyY(grid.keyAt(c));
+            for (uint32_t p = 0; p < cell.count; ++p)
+            for (uint32_t q = p + 1; q < cell.count; ++q) {
+                const Aabb& a = boxes[cell.data[p]];
+                const Aabb& b = boxes[cell.data[q]];
+                if (!a.overlaps(b)) continue;
+                float ox = a.minX > b.minX ? a.minX : b.minX;
+                float oy = a.minY > b.minY ? a.minY : b.minY;
+                if ((int)floorf(ox / cellSize) != cellX || (int)floorf(oy / cellSize) != cellY) continue;
+                ++pairs;
+            }
+        }
+        return pairs;
+    });
+}
+
+// ================= Report =================
+
+static bool writeJson(FILE* f) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"benchmark\": \"physics_bench\",\n");
+    fprintf(f, "  \"simd\": \"%s\",\n", simdLevelName());
+    fprintf(f, "  \"seed\": %u,\n", options.seed);
+    fprintf(f, "  \"pairs\": %u,\n", options.pairs);
+    fprintf(f, "  \"bodies\": %u,\n", options.bodies);
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"ops_per_run\": %llu, \"runs\": %llu, \"ns_per_op\": %.3f, "
+                   "\"pairs_per_sec\": %.1f, \"hits\": %llu}%s\n",
+                r.name.c_str(), (unsigned long long)r.opsPerRun, (unsigned long long)r.runs, r.nsPerOp,
+                r.pairsPerSec, (unsigned long long)r.hits, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return !ferror(f);
+}
+
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "[physics_bench] missing value for %s\n", arg);
+            return false;
+        }
+        if (!strcmp(arg, "--seed")) options.seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--pairs")) options.pairs = (uint32_t)strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--bodies")) options.bodies = (uint32_t)strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--time")) options.minTime = atof(value) / 1000.0;
+        else if (!strcmp(arg, "--out")) options.out = value;
+        else {
+            fprintf(stderr, "[physics_bench] unknown option %s\n", arg);
+            return false;
+        }
+        ++i;
+    }
+    if (options.pairs == 0 || options.bodies == 0) {
+        fprintf(stderr, "[physics_bench] --pairs and --bodies must be > 0\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        fprintf(stderr, "usage: physics_bench [--seed N] [--pairs N] [--bodies N] [--time ms] [--out file]\n");
+        return 1;
+    }
+
+    // one generator per group, adding a benchmark doesn't change the data of the others
+    std::mt19937 narrowRng(options.seed), batchRng(options.seed + 1), broadRng(options.seed + 2);
+    std::mt19937 dedupRng(options.seed + 3);
+    benchNarrowphase(narrowRng);
+    benchBatches(batchRng);
+    benchBroadphase(broadRng);
+    benchPairDedup(dedupRng);
+
+    if (!options.out) return writeJson(stdout) ? 0 : 1;
+
+    FILE* f = fopen(options.out, "w");
+    if (!f) {
+        fprintf(stderr, "[physics_bench] can't open %s\n", options.out);
+        return 1;
+    }
+    bool ok = writeJson(f);
+    fclose(f);
+    return ok ? 0 : 1;
+}
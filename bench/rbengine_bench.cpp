@@ -0,0 +1,506 @@
+//
+//  rbengine_bench.cpp rbashkort 16/10/2026
+//
+//  End-to-end frame benchmark: canonical scenes registered through
+//  Engine::registerScene, each run for a fixed number of ticks with a fixed dt.
+//  Writes frame-time percentiles, the time of the scene-reload ticks, per-system
+//  times, physics phase times and peak memory as JSON to --out (default
+//  rbengine_bench.json).
+//  Regression gate for engine upgrades.
+//
+//  rbengine_bench [--mode headless|gl] [--ticks N] [--warmup N] [--scene name]
+//                 [--seed N] [--out file]
+//
+//  headless: no window, GL, RmlUi or ImGui (Engine::SetHeadless)
+//  gl:       window with Mesa software GL (LIBGL_ALWAYS_SOFTWARE=1 unless set),
+//            needs a display, e.g. xvfb-run on CI machines
+//
+
+#include "engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#define WINDOW_W 1024
+#define WINDOW_H 768
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Options {
+    bool headless = true;
+    int ticks = 600;            // measured ticks per scene
+    int warmup = 60;            // ticks before measuring (first loads, caches, sleep)
+    uint32_t seed = 1234;
+    std::vector<std::string> scenes; // empty = all
+    const char* out = "rbengine_bench.json"; // not stdout, the engine logs there
+};
+
+static Options options;
+
+// Peak resident set of the process so far, KB
+static long peakRssKb() {
+#if defined(__APPLE__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#elif defined(__unix__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+// ================= Scenes =================
+
+// Each scene re-seeds its generator, so every load and reload is the same
+
+// 2000 circles like SceneMenu, bouncing inside static walls
+static void SceneCircles(Engine& eng) {
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> x(40.0f, WINDOW_W - 40.0f), y(40.0f, WINDOW_H - 40.0f);
+    std::uniform_real_distribution<float> r(2.0f, 8.0f), v(-120.0f, 120.0f);
+
+    const float t = 20.0f;
+    const E_Transform walls[4] = {
+        {WINDOW_W * 0.5f, t * 0.5f, 0, 0, 1, 1}, {WINDOW_W * 0.5f, WINDOW_H - t * 0.5f, 0, 0, 1, 1},
+        {t * 0.5f, WINDOW_H * 0.5f, 0, 0, 1, 1}, {WINDOW_W - t * 0.5f, WINDOW_H * 0.5f, 0, 0, 1, 1},
+    };
+    for (int i = 0; i < 4; ++i) {
+        float w = i < 2 ? (float)WINDOW_W : t;
+        float h = i < 2 ? t : (float)WINDOW_H;
+        auto wall = eng.createEntity("");
+        wall.addManyComponents(
+            E_Transform{walls[i]},
+            E_Sprite{E_Sprite::RECTANGLE, w, h, 0},
+            E_Color{eng.ReturnColor(E_WHITE)},
+            E_Collider{ColliderType::Rect, w, h, 0, true}
+        );
+    }
+
+    for (int i = 0; i < 2000; ++i) {
+        auto p = eng.createEntity("");
+        float radius = r(rng);
+        p.addManyComponents(
+            E_Transform{x(rng), y(rng), 0, 0, 1, 1},
+            E_Sprite{E_Sprite::CIRCLE, 0, 0, radius},
+            E_Color{eng.ReturnColor(E_BLUE)},
+            E_Collider{ColliderType::Circle, 0, 0, radius},
+            E_PhysicsMaterial{0.9f, 0.0f},
+            E_EffectTranspare{0.5f},
+            E_Velocity{v(rng), v(rng)}
+        );
+    }
+}
+
+// Dense rect stacks falling on a static floor: contacts, solver, sleeping
+static void SceneRectStacks(Engine& eng) {
+    const float size = 16.0f;
+    const int columns = 40, rows = 25;
+
+    auto floor = eng.createEntity("");
+    floor.addManyComponents(
+        E_Transform{WINDOW_W * 0.5f, WINDOW_H - 10.0f, 0, 0, 1, 1},
+        E_Sprite{E_Sprite::RECTANGLE, (float)WINDOW_W, 20, 0},
+        E_Color{eng.ReturnColor(E_WHITE)},
+        E_Collider{ColliderType::Rect, (float)WINDOW_W, 20, 0, true}
+    );
+
+    for (int c = 0; c < columns; ++c)
+    for (int r = 0; r < rows; ++r) {
+        auto box = eng.createEntity("");
+        box.addManyComponents(
+            E_Transform{80.0f + c * (size + 6.0f), WINDOW_H - 20.0f - size * 0.5f - r * (size + 1.0f), 0, 0, 1, 1},
+            E_Sprite{E_Sprite::RECTANGLE, size, size, 0},
+            E_Color{eng.ReturnColor(E_RED)},
+            E_Collider{ColliderType::Rect, size, size, 0},
+            E_Velocity{0, 0},
+            E_Gravity{500.0f},
+            E_Mass{1.0f}
+        );
+    }
+}
+
+// Many textured sprites drifting slowly, no colliders: render and interpolation
+static void SceneSprites(Engine& eng) {
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> x(0.0f, (float)WINDOW_W), y(0.0f, (float)WINDOW_H);
+    std::uniform_real_distribution<float> v(-15.0f, 15.0f), size(8.0f, 32.0f), angle(0.0f, 360.0f);
+
+    GLuint tex = eng.textureManager.loadTexture("assets/textures/player.png");
+    for (int i = 0; i < 5000; ++i) {
+        auto s = eng.createEntity("");
+        float w = size(rng);
+        s.addManyComponents(
+            E_Transform{x(rng), y(rng), 0, angle(rng), 1, 1},
+            E_Sprite{E_Sprite::RECTANGLE, w, w * 2.0f, 0},
+            E_Texture{tex},
+            E_Color{eng.ReturnColor(E_WHITE)},
+            E_Velocity{v(rng), v(rng)}
+        );
+    }
+}
+
+// HUD: a grid of hover/click buttons under a scripted mouse and bars resized
+// every tick (pick tree updates). In gl mode the RmlUi level document too
+static void SceneHud(Engine& eng) {
+    const int columns = 32, rows = 24;
+    const float w = WINDOW_W / (float)columns, h = WINDOW_H / (float)rows;
+    for (int c = 0; c < columns; ++c)
+    for (int r = 0; r < rows; ++r) {
+        auto button = eng.createEntity("");
+        button.addManyComponents(
+            E_Transform{(c + 0.5f) * w, (r + 0.5f) * h, 1, 0, 1, 1},
+            E_Sprite{E_Sprite::RECTANGLE, w - 4.0f, h - 4.0f, 0},
+            E_Color{eng.ReturnColor(E_GREEN)},
+            E_Clickable{[]() {}},
+            E_EffectHover{1.1f, 1.1f, true},
+            E_EffectOutline{1.0f}
+        );
+    }
+    for (int i = 0; i < 64; ++i) {
+        auto bar = eng.createEntity(("HudBar" + std::to_string(i)).c_str());
+        bar.addManyComponents(
+            E_Transform{8.0f + i * 16.0f, 12.0f, 2, 0, 1, 1},
+            E_Sprite{E_Sprite::RECTANGLE, 12.0f, 16.0f, 0},
+            E_Color{eng.ReturnColor(E_RED)},
+            E_EffectHover{1.2f, 1.2f, true}
+        );
+    }
+}
+
+static void updateHud(Engine& eng, uint64_t frame) {
+    flecs::world& w = eng.getECS().getWorld();
+    for (int i = 0; i < 64; ++i) {
+        flecs::entity bar = w.lookup(("HudBar" + std::to_string(i)).c_str());
+        if (!bar) continue;
+        E_Sprite sprite = bar.get<E_Sprite>();
+        sprite.height = 8.0f + 8.0f * (1.0f + sinf(frame * 0.1f + i));
+        bar.set<E_Sprite>(sprite);
+    }
+
+    if (eng.isHeadless() || !eng.ui.getContext()) return;
+    if (auto doc = eng.ui.getContext()->GetDocument("level1.rml")) {
+        if (auto fill = doc->GetElementById("health-fill"))
+            fill->SetProperty("width", std::to_string(frame % 100) + "%");
+        if (auto score = doc->GetElementById("score-val"))
+            score->SetInnerRML(std::to_string(frame));
+    }
+}
+
+// Medium scene that is reloaded every 30 ticks: scene teardown and setup cost
+static void SceneReload(Engine& eng) {
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> x(0.0f, (float)WINDOW_W), y(0.0f, (float)WINDOW_H), v(-50.0f, 50.0f);
+    for (int i = 0; i < 500; ++i) {
+        auto e = eng.createEntity("");
+        e.addManyComponents(
+            E_Transform{x(rng), y(rng), 0, 0, 1, 1},
+            E_Sprite{E_Sprite::CIRCLE, 0, 0, 6},
+            E_Color{eng.ReturnColor(E_BLUE)},
+            E_Collider{ColliderType::Circle, 0, 0, 6},
+            E_Velocity{v(rng), v(rng)}
+        );
+    }
+}
+
+struct Scenario {
+    const char* name;
+    Engine::SceneInitFunc init;
+    void (*update)(Engine& eng, uint64_t frame);  // per tick, may be null
+    int reloadEvery;                              // ticks, 0 = never
+};
+
+static const Scenario scenarios[] = {
+    {"circles", SceneCircles, nullptr, 0},
+    {"rect_stacks", SceneRectStacks, nullptr, 0},
+    {"sprites", SceneSprites, nullptr, 0},
+    {"hud", SceneHud, updateHud, 0},
+    {"reload", SceneReload, nullptr, 30},
+};
+
+// ================= Measuring =================
+
+struct SystemTime {
+    std::string name;
+    double ms;                  // per tick
+};
+
+struct SceneResult {
+    std::string name;
+    uint32_t entities;
+    double meanMs, p50Ms, p90Ms, p99Ms, maxMs;
+    int reloads;                // ticks that reloaded the scene, part of the frames
+    double reloadMeanMs, reloadMaxMs;
+    std::vector<SystemTime> systems;
+    PhysicsStats physics;       // times and counters per tick
+    long peakRssKb;             // process peak after the scene
+};
+
+// Accumulated time of every system (world.measure_system_time must be on)
+static void systemTimes(flecs::world& w, std::vector<SystemTime>& out) {
+    out.clear();
+    w.query_builder<>().with(flecs::System).build().each([&](flecs::entity e) {
+        const ecs_system_t* sys = ecs_system_get(w.c_ptr(), e.id());
+        const char* name = e.name();
+        if (sys && name) out.push_back({name, (double)sys->time_spent * 1000.0});
+    });
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t i = (size_t)std::ceil(p * (double)sorted.size()) - 1;
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static void addPhysics(PhysicsStats& sum, const PhysicsStats& s) {
+    sum.steps += s.steps;
+    sum.candidatePairs += s.candidatePairs;
+    sum.satTests += s.satTests;
+    sum.batchedTests += s.batchedTests;
+    sum.contacts += s.contacts;
+    sum.integrateMs += s.integrateMs;
+    sum.gatherMs += s.gatherMs;
+    sum.broadphaseMs += s.broadphaseMs;
+    sum.narrowphaseMs += s.narrowphaseMs;
+    sum.solveMs += s.solveMs;
+    sum.sleepMs += s.sleepMs;
+    sum.callbacksMs += s.callbacksMs;
+}
+
+static bool runScenario(Engine& eng, const Scenario& sc, SceneResult& result) {
+    flecs::world& w = eng.getECS().getWorld();
+
+    eng.onUpdate = [&](float) {
+        if (sc.update) sc.update(eng, eng.getFrame());
+        if (!eng.isHeadless()) eng.ui.update();
+    };
+
+    // gl mode: the HUD scene shows the level document like the showcase
+    const bool hudDocument = !eng.isHeadless() && sc.update == updateHud;
+    if (hudDocument) eng.ui.loadDocument("assets/ui/level1.rml");
+
+    eng.loadScene(sc.name);
+    for (int i = 0; i < options.warmup; ++i) {
+        if (!eng.tick()) return false;
+    }
+
+    std::vector<SystemTime> before, after;
+    systemTimes(w, before);
+
+    std::vector<double> frames;
+    frames.reserve(options.ticks);
+    std::vector<double> reloadFrames;
+    PhysicsStats physics;
+    for (int i = 0; i < options.ticks; ++i) {
+        // the scene is loaded at the end of this tick, the request is timed with it
+        const bool reload = sc.reloadEvery > 0 && i % sc.reloadEvery == 0;
+        Clock::time_point start = Clock::now();
+        if (reload) eng.reloadScene();
+        if (!eng.tick()) return false;
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        frames.push_back(ms);
+        if (reload) reloadFrames.push_back(ms);
+        addPhysics(physics, eng.getECS().getPhysicsStats());
+    }
+
+    systemTimes(w, after);
+
+    result.name = sc.name;
+    result.entities = (uint32_t)w.count<SceneEntity>();
+    double sum = 0.0;
+    for (double f : frames) sum += f;
+    std::sort(frames.begin(), frames.end());
+    result.meanMs = frames.empty() ? 0.0 : sum / (double)frames.size();
+    result.p50Ms = percentile(frames, 0.50);
+    result.p90Ms = percentile(frames, 0.90);
+    result.p99Ms = percentile(frames, 0.99);
+    result.maxMs = frames.empty() ? 0.0 : frames.back();
+
+    result.reloads = (int)reloadFrames.size();
+    result.reloadMeanMs = 0.0;
+    result.reloadMaxMs = 0.0;
+    for (double f : reloadFrames) {
+        result.reloadMeanMs += f;
+        result.reloadMaxMs = std::max(result.reloadMaxMs, f);
+    }
+    if (result.reloads) result.reloadMeanMs /= (double)result.reloads;
+
+    // systems are matched by name, the set doesn't change during a run
+    result.systems.clear();
+    for (const SystemTime& a : after) {
+        double start = 0.0;
+        for (const SystemTime& b : before) {
+            if (b.name == a.name) start = b.ms;
+        }
+        result.systems.push_back({a.name, (a.ms - start) / (double)options.ticks});
+    }
+
+    const PhysicsStats& last = eng.getECS().getPhysicsStats();
+    const float perTick = 1.0f / (float)options.ticks;
+    result.physics = physics;
+    result.physics.bodies = last.bodies;
+    result.physics.staticBodies = last.staticBodies;
+    result.physics.integrateMs *= perTick;
+    result.physics.gatherMs *= perTick;
+    result.physics.broadphaseMs *= perTick;
+    result.physics.narrowphaseMs *= perTick;
+    result.physics.solveMs *= perTick;
+    result.physics.sleepMs *= perTick;
+    result.physics.callbacksMs *= perTick;
+    result.peakRssKb = peakRssKb();
+
+    if (hudDocument) eng.ui.closeDocument("assets/ui/level1.rml");
+    eng.onUpdate = nullptr;
+
+    fprintf(stderr, "%-12s p50 %7.3f ms  p99 %7.3f ms  max %7.3f ms  rss %ld KB\n",
+            result.name.c_str(), result.p50Ms, result.p99Ms, result.maxMs, result.peakRssKb);
+    return true;
+}
+
+// ================= Report =================
+
+static bool writeJson(FILE* f, const std::vector<SceneResult>& results) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"benchmark\": \"rbengine_bench\",\n");
+    fprintf(f, "  \"mode\": \"%s\",\n", options.headless ? "headless" : "gl");
+    fprintf(f, "  \"ticks\": %d,\n", options.ticks);
+    fprintf(f, "  \"warmup\": %d,\n", options.warmup);
+    fprintf(f, "  \"seed\": %u,\n", options.seed);
+    fprintf(f, "  \"peak_rss_kb\": %ld,\n", peakRssKb());
+    fprintf(f, "  \"scenes\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SceneResult& r = results[i];
+        const PhysicsStats& p = r.physics;
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"name\": \"%s\",\n", r.name.c_str());
+        fprintf(f, "      \"entities\": %u,\n", r.entities);
+        fprintf(f, "      \"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+                r.meanMs, r.p50Ms, r.p90Ms, r.p99Ms, r.maxMs);
+        fprintf(f, "      \"reload_ms\": {\"count\": %d, \"mean\": %.4f, \"max\": %.4f},\n",
+                r.reloads, r.reloadMeanMs, r.reloadMaxMs);
+        fprintf(f, "      \"systems_ms\": {");
+        for (size_t s = 0; s < r.systems.size(); ++s) {
+            fprintf(f, "%s\"%s\": %.4f", s ? ", " : "", r.systems[s].name.c_str(), r.systems[s].ms);
+        }
+        fprintf(f, "},\n");
+        fprintf(f, "      \"physics\": {\"steps\": %d, \"bodies\": %u, \"static_bodies\": %u, "
+                   "\"candidate_pairs\": %llu, \"sat_tests\": %llu, \"batched_tests\": %llu, \"contacts\": %llu,\n",
+                p.steps, p.bodies, p.staticBodies, (unsigned long long)p.candidatePairs,
+                (unsigned long long)p.satTests, (unsigned long long)p.batchedTests, (unsigned long long)p.contacts);
+        fprintf(f, "                  \"integrate_ms\": %.4f, \"gather_ms\": %.4f, \"broadphase_ms\": %.4f, "
+                   "\"narrowphase_ms\": %.4f, \"solve_ms\": %.4f, \"sleep_ms\": %.4f, \"callbacks_ms\": %.4f},\n",
+                p.integrateMs, p.gatherMs, p.broadphaseMs, p.narrowphaseMs, p.solveMs, p.sleepMs, p.callbacksMs);
+        fprintf(f, "      \"peak_rss_kb\": %ld\n", r.peakRssKb);
+        fprintf(f, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return !ferror(f);
+}
+
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "[rbengine_bench] missing value for %s\n", arg);
+            return false;
+        }
+        if (!strcmp(arg, "--mode")) {
+            if (!strcmp(value, "headless")) options.headless = true;
+            else if (!strcmp(value, "gl")) options.headless = false;
+            else {
+                fprintf(stderr, "[rbengine_bench] unknown mode %s\n", value);
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--ticks")) options.ticks = atoi(value);
+        else if (!strcmp(arg, "--warmup")) options.warmup = atoi(value);
+        else if (!strcmp(arg, "--seed")) options.seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "--scene")) options.scenes.push_back(value);
+        else if (!strcmp(arg, "--out")) options.out = value;
+        else {
+            fprintf(stderr, "[rbengine_bench] unknown option %s\n", arg);
+            return false;
+        }
+        ++i;
+    }
+    if (options.ticks <= 0 || options.warmup < 0) {
+        fprintf(stderr, "[rbengine_bench] --ticks must be > 0, --warmup >= 0\n");
+        return false;
+    }
+    for (const std::string& name : options.scenes) {
+        bool known = false;
+        for (const Scenario& sc : scenarios) known |= name == sc.name;
+        if (!known) {
+            fprintf(stderr, "[rbengine_bench] unknown scene %s\n", name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        fprintf(stderr, "usage: rbengine_bench [--mode headless|gl] [--ticks N] [--warmup N] [--scene name] [--seed N] [--out file]\n");
+        return 1;
+    }
+
+    // software rasterizer, so gl runs compare across machines
+    if (!options.headless) setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    Engine eng;
+    eng.SetHeadless(options.headless);
+    if (!eng.init(WINDOW_W, WINDOW_H, BackGround_BLACK)) { fprintf(stderr, "[Engine] init ka-bum\n"); return 1; }
+    if (!eng.createWindow("rbengine_bench")) { fprintf(stderr, "[Engine] create window ka-bum\n"); return 1; }
+    eng.SetVSync(false);
+    eng.MaxFPS(0);
+    eng.SetTickDelta(1.0f / 60.0f); // one physics step per tick, same work on every machine
+    eng.getECS().getWorld().measure_system_time(true);
+
+    // scripted mouse: sweeps the window row by row, clicks every 20 ticks
+    eng.inputSource = [](uint64_t frame, InputFrame& input) {
+        input.mouseX = (double)((frame * 7) % WINDOW_W);
+        input.mouseY = (double)((frame * 7 / WINDOW_W * 24) % WINDOW_H);
+        input.leftDown = frame % 20 == 0;
+    };
+    if (!options.headless) {
+        eng.onRender = [&]() { eng.ui.render(); };
+    }
+
+    for (const Scenario& sc : scenarios) eng.registerScene(sc.name, sc.init);
+
+    std::vector<SceneResult> results;
+    for (const Scenario& sc : scenarios) {
+        if (!options.scenes.empty() &&
+            std::find(options.scenes.begin(), options.scenes.end(), sc.name) == options.scenes.end()) continue;
+        results.emplace_back();
+        if (!runScenario(eng, sc, results.back())) {
+            fprintf(stderr, "[rbengine_bench] window closed during %s\n", sc.name);
+            return 1;
+        }
+    }
+
+    FILE* f = fopen(options.out, "w");
+    if (!f) {
+        fprintf(stderr, "[rbengine_bench] can't open %s\n", options.out);
+        return 1;
+    }
+    bool ok = writeJson(f, results);
+    fclose(f);
+
+    eng.shutdown();
+    return ok ? 0 : 1;
+}
@@ -7,6 +7,8 @@
 #include "../thirdparty/imgui/imgui.h"
 #include "../thirdparty/imgui/backends/imgui_impl_glfw.h"
 #include "../thirdparty/imgui/backends/imgui_impl_opengl2.h"
+#include "ecs_world.h"
+#include <vector>
 
 class ImGuiLayer {
 public:
@@ -32,10 +34,65 @@ public:
         ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
     }
 
+    // Optional physics window: counters of ECSWorld::getPhysicsStats and a grid
+    // occupancy heatmap over the world (grid broadphase only, brighter = fuller).
+    // Call between begin() and end()
+    void physicsStats(const ECSWorld& ecs) {
+        const PhysicsStats& s = ecs.getPhysicsStats();
+
+        ImGui::Begin("Physics");
+        ImGui::Text("Steps: %d  bodies: %u  static: %u", s.steps, s.bodies, s.staticBodies);
+        if (ImGui::CollapsingHeader("Grid", ImGuiTreeNodeFlags_DefaultOpen)) {
+            ImGui::Text("Cells: %u  entries: %u", s.occupiedCells, s.gridEntries);
+            ImGui::Text("Per cell: max %u  avg %.2f", s.maxPerCell, s.avgPerCell);
+            for (int level = 0; level < MAX_GRID_LEVELS; ++level) {
+                if (s.cellsPerLevel[level]) ImGui::Text("  level %d: %u cells", level, s.cellsPerLevel[level]);
+            }
+            ImGui::Checkbox("Heatmap", &heatmap_);
+        }
+        if (ImGui::CollapsingHeader("Pairs", ImGuiTreeNodeFlags_DefaultOpen)) {
+            ImGui::Text("Cell pairs: %llu", (unsigned long long)s.cellPairs);
+            ImGui::Text("AABB rejects: %llu", (unsigned long long)s.aabbRejects);
+            ImGui::Text("Duplicates: %llu", (unsigned long long)s.duplicatePairs);
+            ImGui::Text("Candidates: %llu", (unsigned long long)s.candidatePairs);
+            ImGui::Text("SAT tests: %llu  batched: %llu", (unsigned long long)s.satTests, (unsigned long long)s.batchedTests);
+            ImGui::Text("Contacts: %llu", (unsigned long long)s.contacts);
+        }
+        if (ImGui::CollapsingHeader("Time (ms)", ImGuiTreeNodeFlags_DefaultOpen)) {
+            ImGui::Text("Integrate:   %.3f", s.integrateMs);
+            ImGui::Text("Gather:      %.3f", s.gatherMs);
+            ImGui::Text("Broadphase:  %.3f", s.broadphaseMs);
+            ImGui::Text("Narrowphase: %.3f", s.narrowphaseMs);
+            ImGui::Text("Solve:       %.3f", s.solveMs);
+            ImGui::Text("Sleep:       %.3f", s.sleepMs);
+            ImGui::Text("Callbacks:   %.3f", s.callbacksMs);
+        }
+        ImGui::End();
+
+        if (!heatmap_) return;
+
+        cells_.clear();
+        ecs.getGridCells(cells_);
+        ImDrawList* draw = ImGui::GetBackgroundDrawList();
+        const float maxCount = s.maxPerCell > 0 ? (float)s.maxPerCell : 1.0f;
+        for (const GridCellStat& c : cells_) {
+            float x0, y0, x1, y1;
+            ecs.worldToScreen(c.x, c.y, x0, y0);
+            ecs.worldToScreen(c.x + c.size, c.y + c.size, x1, y1);
+            float heat = (float)c.count / maxCount;
+            draw->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), ImGui::GetColorU32(ImVec4(heat, 1.0f - heat, 0.0f, 0.15f + 0.35f * heat)));
+            draw->AddRect(ImVec2(x0, y0), ImVec2(x1, y1), IM_COL32(255, 255, 255, 40));
+        }
+    }
+
     void shutdown() {
         ImGui_ImplOpenGL2_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
     }
+
+private:
+    bool heatmap_ = false;
+    std::vector<GridCellStat> cells_;
 };
 
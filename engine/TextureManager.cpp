@@ -3,6 +3,13 @@
 
 GLuint TextureManager::loadTexture(const std::string& path) {
     if (textures.count(path)) return textures[path];
+
+    // nothing is decoded or uploaded, an id per path keeps scene code working
+    if (headless) {
+        GLuint id = (GLuint)textures.size() + 1;
+        textures[path] = id;
+        return id;
+    }
     
     int w, h, nrChannels;
     unsigned char* data = stbi_load(path.c_str(), &w, &h, &nrChannels, 0);
@@ -9,5 +9,10 @@ class TextureManager {
 public:
     GLuint loadTexture(const std::string& path);
     GLuint getTexture(const std::string& path);
+
+    // headless engine: no GL context, loadTexture hands out placeholder ids
+    void setHeadless(bool s) { headless = s; }
+private:
+    bool headless = false;
 };
 
@@ -32,6 +32,7 @@ void UIManager::update() {
 }
 
 void UIManager::render() {
+    if (!context) return;
     glPushAttrib(GL_ALL_ATTRIB_BITS);
 
     glMatrixMode(GL_PROJECTION);
@@ -100,6 +101,7 @@ void UIManager::closeDocument(const std::string& pathOrTitle) {
 
 
 bool UIManager::loadFont(const std::string& path, bool isFallback) {
+    if (!context) return false; // init() not called (headless engine)
     if (!Rml::LoadFontFace(path, isFallback)) {
         printf("[UI] Failed to load font: %s\n", path.c_str());
         return false;
@@ -0,0 +1,424 @@
+//
+//  broadphase.cpp rbashkort 16/10/2026
+//
+
+#include "broadphase.h"
+
+#include <algorithm>
+
+// ================= FlatGrid =================
+
+void FlatGrid::clear() {
+    for (auto& part : parts_) part.clear();
+    cellKeys_.clear();
+    items_.clear();
+}
+
+void FlatGrid::setPartCount(unsigned parts) {
+    if (parts == 0) parts = 1;
+    parts_.resize(parts);
+}
+
+uint32_t FlatGrid::findSlot(uint64_t key) const {
+    uint32_t slot = hashKey(key) & slotMask_;
+    while (slots_[slot] != EMPTY_SLOT && cellKeys_[slots_[slot]] != key) {
+        slot = (slot + 1) & slotMask_;
+    }
+    return slot;
+}
+
+void FlatGrid::build() {
+    uint32_t n = 0;
+    for (const auto& part : parts_) n += (uint32_t)part.size();
+
+    // keep load factor <= 0.5, table only grows
+    uint32_t wanted = 16;
+    while (wanted < n * 2) wanted <<= 1;
+    if (slots_.size() < wanted) slots_.resize(wanted);
+    slotMask_ = (uint32_t)slots_.size() - 1;
+    std::fill(slots_.begin(), slots_.end(), EMPTY_SLOT);
+
+    cellKeys_.clear();
+    cellStart_.clear();
+    entryCell_.resize(n);
+
+    // 1. Assign cell index to every entry and count entries per cell
+    uint32_t i = 0;
+    for (const auto& part : parts_) {
+        for (const Entry& entry : part) {
+            uint32_t slot = findSlot(entry.key);
+            if (slots_[slot] == EMPTY_SLOT) {
+                slots_[slot] = (uint32_t)cellKeys_.size();
+                cellKeys_.push_back(entry.key);
+                cellStart_.push_back(0);
+            }
+            uint32_t c = slots_[slot];
+            entryCell_[i++] = c;
+            cellStart_[c]++;
+        }
+    }
+
+    // 2. Exclusive prefix sum -> offsets
+    const uint32_t cells = (uint32_t)cellKeys_.size();
+    cellStart_.push_back(0);
+    uint32_t sum = 0;
+    for (uint32_t c = 0; c <= cells; ++c) {
+        uint32_t cnt = cellStart_[c];
+        cellStart_[c] = sum;
+        sum += cnt;
+    }
+
+    // 3. Scatter
+    cellFill_.assign(cellStart_.begin(), cellStart_.end() - 1);
+    items_.resize(n);
+    i = 0;
+    for (const auto& part : parts_) {
+        for (const Entry& entry : part) {
+            items_[cellFill_[entryCell_[i++]]++] = entry.item;
+        }
+    }
+}
+
+FlatGrid::Cell FlatGrid::cell(uint64_t key) const {
+    if (cellKeys_.empty()) return {};
+
+    uint32_t slot = findSlot(key);
+    if (slots_[slot] == EMPTY_SLOT) return {};
+
+    uint32_t c = slots_[slot];
+    return { items_.data() + cellStart_[c], cellStart_[c + 1] - cellStart_[c] };
+}
+
+// ================= SweepAndPrune =================
+
+void SweepAndPrune::clear() {
+    proxies_.clear();
+    freeProxies_.clear();
+    order_.clear();
+    added_.clear();
+    lookup_.clear();
+    maxWidth_ = 0.0f;
+}
+
+void SweepAndPrune::update(flecs::entity_t id, const Aabb& box, uint32_t payload) {
+    auto found = lookup_.find(id);
+    if (found != lookup_.end()) {
+        Proxy& p = proxies_[found->second];
+        p.box = box;
+        p.payload = payload;
+        p.lastFrame = frame_;
+        return;
+    }
+
+    uint32_t index;
+    if (!freeProxies_.empty()) {
+        index = freeProxies_.back();
+        freeProxies_.pop_back();
+        proxies_[index] = {id, box, payload, frame_};
+    } else {
+        index = (uint32_t)proxies_.size();
+        proxies_.push_back({id, box, payload, frame_});
+    }
+    lookup_.emplace(id, index);
+    added_.push_back(index);
+}
+
+void SweepAndPrune::endFrame() {
+    // 1. Drop stale proxies, keep relative order of the rest
+    uint32_t w = 0;
+    for (uint32_t i = 0; i < (uint32_t)order_.size(); ++i) {
+        uint32_t idx = order_[i];
+        if (proxies_[idx].lastFrame != frame_) {
+            lookup_.erase(proxies_[idx].id);
+            freeProxies_.push_back(idx);
+            continue;
+        }
+        order_[w++] = idx;
+    }
+    order_.resize(w);
+
+    // 2. Insertion sort on minX of the survivors (nearly sorted from the
+    // previous frame)
+    for (uint32_t i = 1; i < (uint32_t)order_.size(); ++i) {
+        uint32_t idx = order_[i];
+        float key = proxies_[idx].box.minX;
+        uint32_t j = i;
+        while (j > 0 && proxies_[order_[j - 1]].box.minX > key) {
+            order_[j] = order_[j - 1];
+            --j;
+        }
+        order_[j] = idx;
+    }
+
+    // 3. New proxies are in no order: sorted on their own and merged, so a
+    // scene load or mass spawn is O(k log k + n) instead of an O(n^2) insertion sort
+    if (!added_.empty()) {
+        auto byMinX = [&](uint32_t x, uint32_t y) { return proxies_[x].box.minX < proxies_[y].box.minX; };
+        std::sort(added_.begin(), added_.end(), byMinX);
+        const size_t survivors = order_.size();
+        order_.insert(order_.end(), added_.begin(), added_.end());
+        std::inplace_merge(order_.begin(), order_.begin() + survivors, order_.end(), byMinX);
+        added_.clear();
+    }
+
+    maxWidth_ = 0.0f;
+    for (uint32_t idx : order_) maxWidth_ = std::max(maxWidth_, proxies_[idx].box.maxX - proxies_[idx].box.minX);
+}
+
+// ================= AabbTree =================
+
+void AabbTree::clear() {
+    nodes_.clear();
+    lookup_.clear();
+    root_ = NULL_NODE;
+    freeList_ = NULL_NODE;
+}
+
+int AabbTree::allocateNode() {
+    if (freeList_ == NULL_NODE) {
+        nodes_.push_back(Node{});
+        return (int)nodes_.size() - 1;
+    }
+    int index = freeList_;
+    freeList_ = nodes_[index].parent;
+    nodes_[index] = Node{};
+    return index;
+}
+
+void AabbTree::freeNode(int index) {
+    nodes_[index].parent = freeList_;
+    nodes_[index].left = NULL_NODE;
+    nodes_[index].right = NULL_NODE;
+    nodes_[index].height = -1;
+    freeList_ = index;
+}
+
+bool AabbTree::update(flecs::entity_t id, const Aabb& box, uint32_t payload) {
+    auto found = lookup_.find(id);
+    if (found != lookup_.end()) {
+        int leaf = found->second;
+        nodes_[leaf].payload = payload;
+        nodes_[leaf].lastFrame = frame_;
+        if (nodes_[leaf].box.contains(box)) return false; // still inside the fat box
+
+        removeLeaf(leaf);
+        nodes_[leaf].box = {box.minX - FAT_MARGIN, box.minY - FAT_MARGIN,
+                            box.maxX + FAT_MARGIN, box.maxY + FAT_MARGIN};
+        insertLeaf(leaf);
+        return true;
+    }
+
+    int leaf = allocateNode();
+    Node& n = nodes_[leaf];
+    n.box = {box.minX - FAT_MARGIN, box.minY - FAT_MARGIN, box.maxX + FAT_MARGIN, box.maxY + FAT_MARGIN};
+    n.id = id;
+    n.payload = payload;
+    n.height = 0;
+    n.lastFrame = frame_;
+    insertLeaf(leaf);
+    lookup_.emplace(id, leaf);
+    return true;
+}
+
+void AabbTree::remove(flecs::entity_t id) {
+    auto found = lookup_.find(id);
+    if (found == lookup_.end()) return;
+
+    removeLeaf(found->second);
+    freeNode(found->second);
+    lookup_.erase(found);
+}
+
+void AabbTree::endFrame() {
+    for (int i = 0; i < (int)nodes_.size(); ++i) {
+        const Node& n = nodes_[i];
+        if (n.height != 0 || n.lastFrame == frame_) continue;
+        remove(n.id);
+    }
+}
+
+void AabbTree::insertLeaf(int leaf) {
+    if (root_ == NULL_NODE) {
+        root_ = leaf;
+        nodes_[root_].parent = NULL_NODE;
+        return;
+    }
+
+    // 1. Find the best sibling (perimeter heuristic, like Box2D)
+    const Aabb leafBox = nodes_[leaf].box;
+    int index = root_;
+    while (!nodes_[index].isLeaf()) {
+        const Node& n = nodes_[index];
+
+        float perimeter = n.box.perimeter();
+        float combinedPerimeter = Aabb::combine(n.box, leafBox).perimeter();
+
+        // cost of creating a new parent for this node and the leaf
+        float cost = 2.0f * combinedPerimeter;
+        // minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedPerimeter - perimeter);
+
+        auto childCost = [&](int child) {
+            const Node& c = nodes_[child];
+            float grown = Aabb::combine(leafBox, c.box).perimeter();
+            if (c.isLeaf()) return grown + inheritanceCost;
+            return (grown - c.box.perimeter()) + inheritanceCost;
+        };
+        float costLeft = childCost(n.left);
+        float costRight = childCost(n.right);
+
+        if (cost < costLeft && cost < costRight) break;
+        index = (costLeft < costRight) ? n.left : n.right;
+    }
+
+    // 2. Create a new parent for sibling + leaf
+    int sibling = index;
+    int oldParent = nodes_[sibling].parent;
+    int newParent = allocateNode(); // may grow nodes_, no references held here
+
+    nodes_[newParent].parent = oldParent;
+    nodes_[newParent].box = Aabb::combine(leafBox, nodes_[sibling].box);
+    nodes_[newParent].height = nodes_[sibling].height + 1;
+    nodes_[newParent].left = sibling;
+    nodes_[newParent].right = leaf;
+    nodes_[sibling].parent = newParent;
+    nodes_[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        root_ = newParent;
+    } else if (nodes_[oldParent].left == sibling) {
+        nodes_[oldParent].left = newParent;
+    } else {
+        nodes_[oldParent].right = newParent;
+    }
+
+    // 3. Refit and rebalance the ancestors
+    refitUp(nodes_[leaf].parent);
+}
+
+void AabbTree::removeLeaf(int leaf) {
+    if (leaf == root_) {
+        root_ = NULL_NODE;
+        return;
+    }
+
+    int parent = nodes_[leaf].parent;
+    int grandParent = nodes_[parent].parent;
+    int sibling = (nodes_[parent].left == leaf) ? nodes_[parent].right : nodes_[parent].left;
+
+    if (grandParent == NULL_NODE) {
+        root_ = sibling;
+        nodes_[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+
+    // the sibling takes the place of the parent
+    if (nodes_[grandParent].left == parent) nodes_[grandParent].left = sibling;
+    else nodes_[grandParent].right = sibling;
+    nodes_[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refitUp(grandParent);
+}
+
+void AabbTree::refitUp(int index) {
+    while (index != NULL_NODE) {
+        index = balance(index);
+
+        Node& n = nodes_[index];
+        const Node& l = nodes_[n.left];
+        const Node& r = nodes_[n.right];
+        n.height = 1 + (l.height > r.height ? l.height : r.height);
+        n.box = Aabb::combine(l.box, r.box);
+
+        index = n.parent;
+    }
+}
+
+// Tree rotation when the children heights differ by more than one.
+// Returns the index of the node that now sits where `iA` was.
+int AabbTree::balance(int iA) {
+    Node& A = nodes_[iA];
+    if (A.isLeaf() || A.height < 2) return iA;
+
+    int iB = A.left;
+    int iC = A.right;
+    Node& B = nodes_[iB];
+    Node& C = nodes_[iC];
+
+    auto replaceChild = [&](int parent, int oldChild, int newChild) {
+        if (parent == NULL_NODE) root_ = newChild;
+        else if (nodes_[parent].left == oldChild) nodes_[parent].left = newChild;
+        else nodes_[parent].right = newChild;
+    };
+    auto maxi = [](int a, int b) { return a > b ? a : b; };
+
+    int diff = C.height - B.height;
+
+    // Rotate C up
+    if (diff > 1) {
+        int iF = C.left;
+        int iG = C.right;
+        Node& F = nodes_[iF];
+        Node& G = nodes_[iG];
+
+        C.left = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceChild(C.parent, iA, iC);
+
+        if (F.height > G.height) {
+            C.right = iF;
+            A.right = iG;
+            G.parent = iA;
+            A.box = Aabb::combine(B.box, G.box);
+            C.box = Aabb::combine(A.box, F.box);
+            A.height = 1 + maxi(B.height, G.height);
+            C.height = 1 + maxi(A.height, F.height);
+        } else {
+            C.right = iG;
+            A.right = iF;
+            F.parent = iA;
+            A.box = Aabb::combine(B.box, F.box);
+            C.box = Aabb::combine(A.box, G.box);
+            A.height = 1 + maxi(B.height, F.height);
+            C.height = 1 + maxi(A.height, G.height);
+        }
+        return iC;
+    }
+
+    // Rotate B up
+    if (diff < -1) {
+        int iD = B.left;
+        int iE = B.right;
+        Node& D = nodes_[iD];
+        Node& E = nodes_[iE];
+
+        B.left = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceChild(B.parent, iA, iB);
+
+        if (D.height > E.height) {
+            B.right = iD;
+            A.left = iE;
+            E.parent = iA;
+            A.box = Aabb::combine(C.box, E.box);
+            B.box = Aabb::combine(A.box, D.box);
+            A.height = 1 + maxi(C.height, E.height);
+            B.height = 1 + maxi(A.height, D.height);
+        } else {
+            B.right = iE;
+            A.left = iD;
+            D.parent = iA;
+            A.box = Aabb::combine(C.box, D.box);
+            B.box = Aabb::combine(A.box, E.box);
+            A.height = 1 + maxi(C.height, D.height);
+            B.height = 1 + maxi(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
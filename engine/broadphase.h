@@ -0,0 +1,339 @@
+//
+//  broadphase.h rbashkort 16/10/2026
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <flecs.h>
+
+enum class BroadphaseMode {
+    Grid,           // hierarchical grid (cell size per body size), rebuilt every frame
+    SweepAndPrune,  // sorted intervals on X, kept sorted across frames
+    AabbTree        // dynamic bounding volume hierarchy with fat boxes
+};
+
+struct Aabb {
+    float minX, minY, maxX, maxY;
+
+    bool overlaps(const Aabb& o) const {
+        return minX <= o.maxX && o.minX <= maxX && minY <= o.maxY && o.minY <= maxY;
+    }
+    bool contains(const Aabb& o) const {
+        return minX <= o.minX && minY <= o.minY && o.maxX <= maxX && o.maxY <= maxY;
+    }
+    float perimeter() const { return 2.0f * ((maxX - minX) + (maxY - minY)); }
+
+    // Slab test of the segment p + d * t, t in [0, maxT]
+    bool intersectsSegment(float px, float py, float dx, float dy, float maxT) const {
+        float t0, t1;
+        return clipSegment(px, py, dx, dy, maxT, t0, t1);
+    }
+
+    // Part [t0, t1] of the segment p + d * t, t in [0, maxT], inside the box.
+    // False if the segment misses it
+    bool clipSegment(float px, float py, float dx, float dy, float maxT, float& t0, float& t1) const {
+        t0 = 0.0f;
+        t1 = maxT;
+        const float p[2] = {px, py}, d[2] = {dx, dy};
+        const float lo[2] = {minX, minY}, hi[2] = {maxX, maxY};
+        for (int axis = 0; axis < 2; ++axis) {
+            if (d[axis] == 0.0f) {
+                if (p[axis] < lo[axis] || p[axis] > hi[axis]) return false;
+                continue;
+            }
+            float inv = 1.0f / d[axis];
+            float tNear = (lo[axis] - p[axis]) * inv;
+            float tFar = (hi[axis] - p[axis]) * inv;
+            if (tNear > tFar) { float tmp = tNear; tNear = tFar; tFar = tmp; }
+            if (tNear > t0) t0 = tNear;
+            if (tFar < t1) t1 = tFar;
+            if (t0 > t1) return false;
+        }
+        return true;
+    }
+
+    static Aabb combine(const Aabb& a, const Aabb& b) {
+        return { a.minX < b.minX ? a.minX : b.minX, a.minY < b.minY ? a.minY : b.minY,
+                 a.maxX > b.maxX ? a.maxX : b.maxX, a.maxY > b.maxY ? a.maxY : b.maxY };
+    }
+};
+
+// Collision layers, E_Collider::layer is an index in [0, MAX_LAYERS)
+constexpr int MAX_LAYERS = 32;
+static inline uint32_t layerBit(int layer) { return 1u << (layer & (MAX_LAYERS - 1)); }
+
+// Grid levels (hierarchical grid): level k has cells 4^k times the base size,
+// a collider goes to the level whose cells fit its box
+constexpr int MAX_GRID_LEVELS = 8;
+
+// Hashing helper for spatial grid. Key = layer (5 bits) | level (3 bits) | x (28 bits) | y (28 bits),
+// so every layer and level has its own cells (broadphase partition) in the same grid
+static inline uint64_t hashCellGlobal(int x, int y, int layer = 0, int level = 0) {
+    const uint64_t mask28 = (1u << 28) - 1;
+    return (uint64_t(layer & (MAX_LAYERS - 1)) << 59) | (uint64_t(level & (MAX_GRID_LEVELS - 1)) << 56) |
+           ((uint64_t((uint32_t)x) & mask28) << 28) | (uint64_t((uint32_t)y) & mask28);
+}
+static inline int cellKeyX(uint64_t key) { return (int32_t)((uint32_t)(key >> 28) << 4) >> 4; }
+static inline int cellKeyY(uint64_t key) { return (int32_t)((uint32_t)key << 4) >> 4; }
+static inline int cellKeyLayer(uint64_t key) { return (int)(key >> 59); }
+static inline int cellKeyLevel(uint64_t key) { return (int)(key >> 56) & (MAX_GRID_LEVELS - 1); }
+
+// Flat uniform grid for the broadphase.
+// Entries are staged with insert() and then counting-sorted by cell in build(),
+// so every cell is a contiguous slice of one array. All buffers keep their
+// capacity between frames -> no heap allocation once the world has warmed up.
+// Items are body indices of the current frame.
+//
+// Staging can be split in parts (one per thread), build() merges them.
+class FlatGrid {
+public:
+    struct Cell {
+        const uint32_t* data = nullptr;
+        uint32_t count = 0;
+
+        const uint32_t* begin() const { return data; }
+        const uint32_t* end() const { return data + count; }
+        bool empty() const { return count == 0; }
+    };
+
+    struct Entry {
+        uint64_t key;
+        uint32_t item;
+    };
+
+    // Drops all entries (capacity is kept)
+    void clear();
+
+    // Number of staging buffers, one per writer thread
+    void setPartCount(unsigned parts);
+
+    // Stage item for the cell with given key (see hashCellGlobal)
+    void insert(uint64_t key, uint32_t item) { parts_[0].push_back({key, item}); }
+    void insert(unsigned part, uint64_t key, uint32_t item) { parts_[part].push_back({key, item}); }
+
+    // Counting sort of staged entries into per-cell slices
+    void build();
+
+    // Items of the cell, empty if the cell is not occupied
+    Cell cell(uint64_t key) const;
+
+    // Occupied cells by index in [0, cellCount()), for walking the whole grid
+    Cell cellAt(uint32_t c) const { return { items_.data() + cellStart_[c], cellStart_[c + 1] - cellStart_[c] }; }
+    uint64_t keyAt(uint32_t c) const { return cellKeys_[c]; }
+
+    uint32_t cellCount() const { return (uint32_t)cellKeys_.size(); }
+    uint32_t entryCount() const { return (uint32_t)items_.size(); }
+
+private:
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+
+    static uint32_t hashKey(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return (uint32_t)key;
+    }
+
+    uint32_t findSlot(uint64_t key) const;
+
+    std::vector<std::vector<Entry>> parts_ = std::vector<std::vector<Entry>>(1); // staged (key, item) pairs
+    std::vector<uint32_t> entryCell_;     // cell index of every entry (parts concatenated)
+
+    // open addressing table: slot -> cell index (EMPTY_SLOT if free)
+    std::vector<uint32_t> slots_;
+    uint32_t slotMask_ = 0;
+
+    std::vector<uint64_t> cellKeys_;      // cell index -> key
+    std::vector<uint32_t> cellStart_;     // cell index -> offset in items_ (size = cells + 1)
+    std::vector<uint32_t> cellFill_;      // scatter cursor
+    std::vector<uint32_t> items_;         // items sorted by cell
+};
+
+// Sort-and-sweep broadphase.
+// Proxies live across frames, the X-sorted order is repaired with insertion
+// sort, so with small per-frame motion the update is close to O(n).
+//
+// Usage per frame: beginFrame(), update() for every live collider, endFrame(),
+// then findPairs(). Proxies not updated in a frame are removed in endFrame().
+class SweepAndPrune {
+public:
+    void beginFrame() { ++frame_; }
+    // payload is handed back by findPairs (body index of this frame)
+    void update(flecs::entity_t id, const Aabb& box, uint32_t payload);
+    void endFrame();
+    void clear();
+
+    // Calls f(payloadA, payloadB) for every pair with overlapping boxes (each pair once)
+    template<typename F>
+    void findPairs(F&& f) const {
+        const uint32_t n = (uint32_t)order_.size();
+        for (uint32_t i = 0; i < n; ++i) {
+            const Proxy& a = proxies_[order_[i]];
+            for (uint32_t j = i + 1; j < n; ++j) {
+                const Proxy& b = proxies_[order_[j]];
+                if (b.box.minX > a.box.maxX) break;
+                if (b.box.minY > a.box.maxY || a.box.minY > b.box.maxY) continue;
+                f(a.payload, b.payload);
+            }
+        }
+    }
+
+    // Calls f(payload) for every proxy whose box overlaps the box. Binary search
+    // on minX, then a sweep from maxWidth_ before box.minX to box.maxX: about
+    // O(log n + k) for boxes of collider size, up to O(n) when one proxy spans
+    // the world (every query then starts at the left end)
+    template<typename F>
+    void query(const Aabb& box, F&& f) const {
+        const float from = box.minX - maxWidth_;
+        auto it = std::lower_bound(order_.begin(), order_.end(), from, [&](uint32_t idx, float x) {
+            return proxies_[idx].box.minX < x;
+        });
+        for (; it != order_.end(); ++it) {
+            const Proxy& p = proxies_[*it];
+            if (p.box.minX > box.maxX) break;
+            if (p.box.overlaps(box)) f(p.payload);
+        }
+    }
+
+    uint32_t proxyCount() const { return (uint32_t)order_.size(); }
+
+private:
+    struct Proxy {
+        flecs::entity_t id;
+        Aabb box;
+        uint32_t payload;
+        uint32_t lastFrame;
+    };
+
+    std::vector<Proxy> proxies_;
+    std::vector<uint32_t> freeProxies_;
+    std::vector<uint32_t> order_;    // proxy indices sorted by box.minX
+    std::vector<uint32_t> added_;    // proxies created this frame, not in order_ yet
+    std::unordered_map<flecs::entity_t, uint32_t> lookup_;
+    float maxWidth_ = 0.0f;          // widest box on X, how far back query() starts
+    uint32_t frame_ = 0;
+};
+
+// Dynamic AABB tree (balanced BVH).
+// Leaves store "fat" boxes: the real box grown by FAT_MARGIN. A collider is
+// only re-inserted when its real box leaves the fat one, so slow or resting
+// bodies cost nothing to update. Box size is not limited (level walls etc).
+//
+// Per frame usage is the same as SweepAndPrune.
+class AabbTree {
+public:
+    static constexpr float FAT_MARGIN = 8.0f;
+
+    void beginFrame() { ++frame_; }
+    // Returns true if the leaf had to be (re)inserted.
+    // payload is handed back by query/findPairs
+    bool update(flecs::entity_t id, const Aabb& box, uint32_t payload);
+    void endFrame();
+    void remove(flecs::entity_t id);
+    void clear();
+
+    // Calls f(payload) for every leaf whose fat box overlaps the box
+    template<typename F>
+    void query(const Aabb& box, F&& f) const {
+        if (root_ == NULL_NODE) return;
+
+        int stack[MAX_STACK];
+        int top = 0;
+        stack[top++] = root_;
+        while (top > 0) {
+            const Node& n = nodes_[stack[--top]];
+            if (!n.box.overlaps(box)) continue;
+            if (n.isLeaf()) {
+                f(n.payload);
+            } else {
+                stack[top++] = n.left;
+                stack[top++] = n.right;
+            }
+        }
+    }
+
+    // Calls f(payload, maxT) for leaves whose fat box the segment p + d * t,
+    // t in [0, maxT] crosses. f returns the new maxT (the hit, for closest-hit
+    // queries). Returns the final maxT
+    template<typename F>
+    float raycast(float px, float py, float dx, float dy, float maxT, F&& f) const {
+        if (root_ == NULL_NODE) return maxT;
+
+        int stack[MAX_STACK];
+        int top = 0;
+        stack[top++] = root_;
+        while (top > 0) {
+            const Node& n = nodes_[stack[--top]];
+            if (!n.box.intersectsSegment(px, py, dx, dy, maxT)) continue;
+            if (n.isLeaf()) {
+                maxT = f(n.payload, maxT);
+            } else {
+                stack[top++] = n.left;
+                stack[top++] = n.right;
+            }
+        }
+        return maxT;
+    }
+
+    // Calls f(payloadA, payloadB) once for every pair of leaves with overlapping fat boxes
+    template<typename F>
+    void findPairs(F&& f) const {
+        int stack[MAX_STACK];
+        for (int leaf = 0; leaf < (int)nodes_.size(); ++leaf) {
+            const Node& a = nodes_[leaf];
+            if (!a.isLeaf() || a.height < 0) continue;
+
+            int top = 0;
+            stack[top++] = root_;
+            while (top > 0) {
+                int index = stack[--top];
+                const Node& n = nodes_[index];
+                if (!n.box.overlaps(a.box)) continue;
+                if (n.isLeaf()) {
+                    if (index > leaf) f(a.payload, n.payload); // report each pair from the lower leaf only
+                } else {
+                    stack[top++] = n.left;
+                    stack[top++] = n.right;
+                }
+            }
+        }
+    }
+
+    uint32_t proxyCount() const { return (uint32_t)lookup_.size(); }
+    int height() const { return root_ == NULL_NODE ? 0 : nodes_[root_].height; }
+
+private:
+    static constexpr int NULL_NODE = -1;
+    // balanced tree -> height ~ 1.44 * log2(n), 256 is plenty
+    static constexpr int MAX_STACK = 256;
+
+    struct Node {
+        Aabb box;
+        flecs::entity_t id = 0;
+        uint32_t payload = 0;
+        int parent = NULL_NODE;   // next free node when on the free list
+        int left = NULL_NODE;
+        int right = NULL_NODE;
+        int height = -1;          // 0 = leaf, -1 = free
+        uint32_t lastFrame = 0;
+
+        bool isLeaf() const { return left == NULL_NODE; }
+    };
+
+    int allocateNode();
+    void freeNode(int index);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    void refitUp(int index);
+    int balance(int index);
+
+    std::vector<Node> nodes_;
+    int root_ = NULL_NODE;
+    int freeList_ = NULL_NODE;
+    std::unordered_map<flecs::entity_t, int> lookup_;
+    uint32_t frame_ = 0;
+};
@@ -0,0 +1,201 @@
+//
+//  collision.h rbashkort 16/10/2026
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <flecs.h>
+#include "components.h"
+#include "broadphase.h"
+#include "physics_simd.h"
+#include "shape_pool.h"
+
+// World-space geometry of a collider, computed once per frame (once per sync
+// for static colliders), so the narrowphase never rebuilds vertices per pair
+struct WorldShape {
+    float cx = 0.0f, cy = 0.0f;  // center (transform + offset)
+    float mx = 0.0f, my = 0.0f;  // vertex centroid, orients the polygon MTV
+    float radius = 0.0f;         // circle radius, bounding radius for polygons
+    int count = 0;               // polygon vertices, 0 for circles
+    float vx[4], vy[4];          // vertices
+    float nx[4], ny[4];          // unit normal of edge v[i] -> v[i+1], zero if degenerate
+    // pool polygon (ColliderType::Polygon): count = 0, the vertices stay in
+    // local space and are rotated by (cs, sn) on demand (GJK support points)
+    const ConvexPolygon* hull = nullptr;
+    float cs = 1.0f, sn = 0.0f;
+};
+
+// Per-frame snapshot of one collider, filled before the broadphase.
+// The narrowphase only reads the snapshot (t, c, box), so it can run on worker
+// threads. The pointers are written in the serial resolve step only.
+struct PhysicsBody {
+    flecs::entity_t id = 0;
+    uint32_t part = 0;                 // tile map rect (static slot + 1), 0 for E_Collider bodies
+    E_Transform* transform = nullptr;  // nullptr for static bodies (never moved)
+    E_Velocity* velocity = nullptr;    // nullptr if the entity has no E_Velocity
+    E_Sleep* sleep = nullptr;          // nullptr until the engine added E_Sleep
+
+    E_Transform t {};
+    E_Collider c {};
+    Aabb box {};
+    WorldShape shape {};
+
+    float invMass = 1.0f;
+    float restitution = 0.3f;
+    float friction = 0.3f;
+    bool hasMaterial = false;
+
+    float vx = 0.0f, vy = 0.0f;        // solver velocity, written back to *velocity
+    float dx = 0.0f, dy = 0.0f;        // bullets: displacement of this step
+    bool bullet = false;
+    bool rewound = false;              // bullet moved back to its time of impact
+    uint8_t gridLevel = 0;             // grid mode: level whose cells fit the box
+    bool sleeping = false;             // static side: asleep dynamic body, woken on contact
+    bool touching = false;             // has a contact manifold this step (sleep test)
+};
+
+// Read-only view of a contiguous buffer
+template<typename T>
+struct Span {
+    const T* data = nullptr;
+    size_t count = 0;
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return data[i]; }
+};
+
+// Scene queries (ECSWorld::raycast etc.)
+struct Ray {
+    float x, y;     // start
+    float dx, dy;   // end = start + d
+};
+
+struct RayHit {
+    flecs::entity_t entity = 0; // 0 = nothing hit
+    float x = 0.0f, y = 0.0f;   // hit point
+    float nx = 0.0f, ny = 0.0f; // surface normal
+    float fraction = 1.0f;      // along the ray / cast, [0, 1]
+};
+
+struct QueryFilter {
+    uint32_t layers = 0xFFFFFFFFu;    // bit per collision layer
+    bool includeTriggers = false;
+    flecs::entity_t ignore = 0;       // e.g. the entity casting the ray
+};
+
+// Candidate pair from the broadphase (indices of dynamic bodies)
+struct BodyPair {
+    uint32_t a, b;
+};
+
+// Result of the narrowphase for one pair. mtv pushes B out of A.
+struct Contact {
+    flecs::entity_t lo, hi;     // sorted entity ids, key of the deterministic resolve order
+    uint32_t part;              // PhysicsBody::part of B, splits the key for tile maps
+    uint32_t bodyA, bodyB;      // A is always dynamic
+    bool staticB;               // bodyB indexes the static bodies
+    bool isSensor;
+    float mtvX, mtvY;
+};
+
+// Narrowphase result of a trigger pair, reused while both bodies keep their pose
+struct TriggerTest {
+    struct Pose {
+        float x, y, angle, radius;
+        bool operator==(const Pose& o) const { return x == o.x && y == o.y && angle == o.angle && radius == o.radius; }
+    };
+    flecs::entity_t lo, hi;
+    uint32_t part;
+    Pose poseLo, poseHi;
+    bool overlap;
+
+    bool operator<(const TriggerTest& o) const {
+        if (lo != o.lo) return lo < o.lo;
+        return hi != o.hi ? hi < o.hi : part < o.part;
+    }
+};
+
+// Current overlap of a trigger, sorted by (lo, hi)
+struct TriggerPair {
+    flecs::entity_t lo, hi;
+    flecs::entity_t trigger, other;
+};
+
+// First touch of a bullet pair that the discrete test missed. n from A to B
+struct Impact {
+    uint32_t bodyA, bodyB;
+    bool staticB;
+    float t;
+    float nx, ny;
+};
+
+// Contact constraint of one pair. Manifolds are sorted by (lo, hi) like the
+// contacts, last frame's list is merged in to warm start the impulses
+struct ContactManifold {
+    flecs::entity_t lo, hi;
+    uint32_t part;
+    uint32_t bodyA, bodyB;
+    bool staticB;
+    float nx, ny;               // unit normal, A -> B
+    float depth;
+    float mass;                 // 1 / (invMassA + invMassB), velocity part
+    float friction;
+    float velocityBias;         // restitution target
+    float normalImpulse = 0.0f; // accumulated over the iterations
+    float tangentImpulse = 0.0f;
+};
+
+// Counters of the physics steps of the last update() (ECSWorld::getPhysicsStats).
+// Pair, test and time values are summed over the steps, body and grid values
+// are from the last step. Times in milliseconds
+struct PhysicsStats {
+    int steps = 0;
+    uint32_t bodies = 0;            // moving colliders
+    uint32_t staticBodies = 0;      // static slots in use (colliders, tile rects, sleepers)
+
+    // grid mode
+    uint32_t occupiedCells = 0;
+    uint32_t cellsPerLevel[MAX_GRID_LEVELS] = {};
+    uint32_t gridEntries = 0;       // body-in-cell entries
+    uint32_t maxPerCell = 0;
+    float avgPerCell = 0.0f;
+    uint64_t cellPairs = 0;         // body pairs looked at inside cells
+    uint64_t aabbRejects = 0;       // ... whose boxes don't overlap
+    uint64_t duplicatePairs = 0;    // ... reported by the cell that owns the overlap instead
+
+    uint64_t candidatePairs = 0;    // broadphase output: dynamic pairs + static tree hits
+    uint64_t satTests = 0;          // scalar SAT/GJK tests
+    uint64_t batchedTests = 0;      // pairs run through the batched kernels
+    uint64_t contacts = 0;
+
+    // one field per stage, in stage order
+    float integrateMs = 0.0f;       // velocities and gravity into the transforms
+    float gatherMs = 0.0f;          // snapshot + world shapes
+    float broadphaseMs = 0.0f;      // build + pair search
+    float narrowphaseMs = 0.0f;     // pair tests, bullet sweeps and rewinds, contact sort
+    float solveMs = 0.0f;           // trigger and collision events, manifolds, solver
+    float sleepMs = 0.0f;           // idle timers, bodies put to sleep
+    float callbacksMs = 0.0f;       // onCollision callbacks (user code)
+};
+
+// Occupied grid cell, for debug views (ECSWorld::getGridCells)
+struct GridCellStat {
+    float x, y, size;               // min corner and edge in world units
+    uint32_t count;                 // bodies in the cell
+    int layer, level;
+};
+
+// Per-worker narrowphase scratch. Simple shape pairs are bucketed by type and
+// tested with the batched kernels, everything else goes through scalar SAT.
+struct NarrowphaseBatches {
+    enum : uint8_t { StaticB = 1, Flipped = 2 };  // ShapeBatch::flags
+
+    ShapeBatch circleCircle;
+    ShapeBatch boxBox;        // axis-aligned rects only (angle == 0)
+    ShapeBatch circleBox;     // A is the circle, Flipped if it was B
+};
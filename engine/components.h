@@ -6,9 +6,11 @@
 
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
+#include <cstdint>
 #include <functional>
 #include <flecs.h>
 #include <string>
+#include <vector>
 
 struct BackGroundColor {
     GLfloat r, g, b, a;
@@ -40,6 +42,9 @@ struct E_Transform {
     float xScale, yScale;
 };
 struct E_Velocity { float vx = 0, vy = 0; bool freeze = false; };
+// Transform before the last physics step, added by the engine to bodies with E_Velocity.
+// RenderSystem draws between it and E_Transform
+struct E_PrevTransform { float x, y, angle; };
 struct E_Gravity { float a = 9.81; bool work = true; };
 struct E_Color { float r, g, b; };
 struct E_Texture { GLuint id; };
@@ -80,6 +85,15 @@ struct E_InputState {
     bool _prevKeysDown[350]; // prev state
 };
 
+// Raw input of one tick, E_InputState derives the pressed/released edges from it.
+// Filled from the window, or by Engine::inputSource in headless mode (script, replay)
+struct InputFrame {
+    double mouseX = 0.0, mouseY = 0.0;
+    bool leftDown = false;
+    bool rightDown = false;
+    bool keysDown[350] = {};
+};
+
 struct E_Clickable {
     std::function<void()> onClick;
 
@@ -99,7 +113,8 @@ struct E_EffectTranspare { float alpha = 0.9; bool work = true; };
 enum class ColliderType {
     Rect,       // AABB
     Circle,     // Circle
-    Triangle    //Polygon     // Any form
+    Triangle,   // isosceles, width x height
+    Polygon     // any convex polygon, see createPolygon() in shape_pool.h
 };
 
 struct E_Collider {
@@ -112,17 +127,59 @@ struct E_Collider {
     bool isTrigger = false;
     bool active = true;
 
-    int layer = 1;
+    int layer = 1;           // collision layer [0, 32), see ECSWorld::setLayerCollision
     // offset from Transform
     float offsetX = 0, offsetY = 0;
+
+    bool isBullet = false; // fast mover: its motion is swept each step (CCD), costs more
+    uint32_t mask = 0xFFFFFFFFu; // layers this collider accepts, bit per layer
+    uint32_t polygon = 0;        // ColliderType::Polygon: id from createPolygon()
 };
 
+// Static level geometry on a grid of tiles, one entity for the whole map.
+// Solid tiles are merged per chunk into as few rectangles as possible (greedy
+// meshing), which go to the static collision tree as plain rect colliders.
+// E_Transform is the top-left corner of tile (0, 0), angle and scale are ignored.
+// Change tiles with ECSWorld::setTile (rebuilds one chunk) or set<E_TileMap> (all)
+struct E_TileMap {
+    int width = 0, height = 0;     // in tiles
+    float tileSize = 32.0f;
+    int chunkSize = 32;            // tiles per chunk side
+    std::vector<uint8_t> solid;    // width * height, row by row, non-zero = solid
+
+    int layer = 1;                 // as E_Collider
+    uint32_t mask = 0xFFFFFFFFu;
+};
+
+// Tag, added by the engine to colliders with isStatic = true (don't add by hand)
+struct E_StaticCollider { };
+
+// Sleep timer of a dynamic collider, added by the engine if missing.
+// Add it yourself with canSleep = false to keep a body always awake
+struct E_Sleep {
+    float idleTime = 0.0f;  // seconds under the sleep velocity
+    bool canSleep = true;
+};
+
+// Tag, added by the engine to sleeping bodies (don't add by hand).
+// Sleepers skip gravity, movement and the dynamic broadphase
+struct E_Asleep { };
+
+// Element of ECSWorld::collisionEvents() / onCollision() callbacks (not a component)
 struct E_CollisionEvent {
     flecs::entity a;
     flecs::entity b;
     bool isTrigger;
 };
 
+// Element of ECSWorld::triggerEvents() (not a component): an overlap with a
+// trigger started (entered) or ended. other may be dead already on exit
+struct E_TriggerEvent {
+    flecs::entity trigger;
+    flecs::entity other;
+    bool entered;
+};
+
 struct E_Mass {
     float mass = 1.0f;
     float invMass = 1.0f; // 1/mass, for static = 0
@@ -135,7 +192,7 @@ struct E_Mass {
 
 struct E_PhysicsMaterial {
     float restitution = 0.3f;  // 0 = no bounce, 1 = perfect bounce
-    float friction = 0.3f;     // [0..1], for future (not in use yet)
+    float friction = 0.3f;     // [0..1], mixed as sqrt(a * b)
 };
 
 // Heshing
@@ -13,323 +13,186 @@
 #include <flecs/addons/cpp/mixins/pipeline/decl.hpp>
 #include <flecs/addons/cpp/ref.hpp>
 #include <math.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
 #include <cstdio>
 
+using StatsClock = std::chrono::high_resolution_clock;
+
+// ms since `since`, then moves it to now
+static float lapMs(StatsClock::time_point& since) {
+    StatsClock::time_point now = StatsClock::now();
+    float ms = std::chrono::duration<float, std::milli>(now - since).count();
+    since = now;
+    return ms;
+}
+
 template<typename... Components>
 static void register_components(flecs::world& w) {
     (w.component<Components>(), ...);
 }
 
-ECSWorld::ECSWorld() : world() {}
+ECSWorld::ECSWorld() : world() {
+    // by default a layer only collides with itself
+    for (int i = 0; i < MAX_LAYERS; ++i) layerMatrix_[i] = layerBit(i);
+}
 
-void ECSWorld::init() {
+ECSWorld::~ECSWorld() {
+    // the observers write into staticTree_, which is destroyed before the world
+    if (staticSync_.id() != 0) staticSync_.destruct();
+    if (tileMapSync_.id() != 0) tileMapSync_.destruct();
+    if (wakeSync_.id() != 0) wakeSync_.destruct();
+    if (pickSync_.id() != 0) pickSync_.destruct();
+}
+
+void ECSWorld::init(bool headless) {
     printf("[Engine] ECS world init called\n");
 
-    register_components<E_Transform, E_Velocity, E_Color, E_Texture, E_Sprite, E_Camera,
+    register_components<E_Transform, E_Velocity, E_PrevTransform, E_Color, E_Texture, E_Sprite, E_Camera,
         E_InputState, E_Clickable, E_EffectHover, E_EffectShadow, E_EffectOutline, E_EffectTranspare,
-        E_Mass, E_PhysicsMaterial, E_Collider, E_CollisionEvent, E_Gravity, E_WindowSize>(world);
+        E_Mass, E_PhysicsMaterial, E_Collider, E_TileMap, E_StaticCollider, E_Sleep, E_Asleep, E_Gravity, E_WindowSize>(world);
     
     E_InputState initState;
     memset(&initState, 0, sizeof(E_InputState));
     world.set<E_InputState>(initState);
     printf("[Engine] Components registered\n");
 
-    qColliders_ = world.query<E_Transform, E_Collider>();
+    qDynamic_ = world.query_builder<E_Transform, E_Collider, E_Velocity*, E_Mass*, E_PhysicsMaterial*, E_Sleep*,
+                                    const E_PrevTransform*>()
+        .without<E_StaticCollider>()
+        .without<E_Asleep>()
+        .build();
+    qAsleep_ = world.query_builder<const E_Transform, const E_Velocity*>()
+        .with<E_Asleep>()
+        .build();
     qCamera_ = world.query<E_Transform, E_Camera>();
-
-    // --- Move System ---
-    world.system<E_Transform, E_Velocity>("MoveSystem")
-        .each([](flecs::entity e, E_Transform& t, E_Velocity& v) {
-            float dt = e.world().delta_time();
-            if (!v.freeze) {
-                t.x += v.vx * dt;
-                t.y += v.vy * dt;
-            }
-        });
-
-    // --- Gravity System ---
-    world.system<E_Velocity, E_Gravity>("GravitySystem")
-        .each([](flecs::entity e, E_Velocity& v, E_Gravity& g) {
-            if (g.work && !v.freeze) {
-                float dt = e.world().delta_time();
-                v.vy += g.a * dt;
-            }
-        }); 
+    qPrevTransform_ = world.query_builder<const E_Transform, E_PrevTransform*>()
+        .with<E_Velocity>()
+        .build();
+    qPickMoving_ = world.query_builder<const E_Transform, const E_Sprite>()
+        .with<E_Velocity>()
+        .with<E_Clickable>().or_()
+        .with<E_EffectHover>()
+        .build();
 
     // --------------------------------------------------------
-    // Helpers (Local lambdas)
+    // Physics: kind(0) systems, not in the pipeline. update() runs them
+    // with the fixed step, as often as the accumulator allows
     // --------------------------------------------------------
-    auto aabbHalfExtents = [](const E_Collider& c) -> Vec2 {
-        if (c.type == ColliderType::Circle) return {c.radius, c.radius};
-        float hx = c.width * 0.5f;
-        float hy = c.height * 0.5f;
-        float r = std::sqrt(hx*hx + hy*hy);
-        return {r, r};
-    };
 
-    // --------------------------------------------------------
-    // System 1: Build Grid (PreUpdate)
-    // --------------------------------------------------------
-    world.system<>("BuildBroadphaseGrid")
-        .kind(flecs::PreUpdate)
+    // --- Integrate System ---
+    // Gravity + velocity + position of every awake body in one SIMD pass over
+    // bodyStore_ (see integrateBodies). Tables are copied in and out in chunks
+    // on the physics threads
+    integrateSystem_ = world.system<E_Transform, E_Velocity, const E_Gravity*>("IntegrateSystem")
+        .kind(0)
+        .without<E_Asleep>()
         .run([this](flecs::iter& it) {
-            grid_.clear();
-            bigBodies_.clear();
-            testedPairs_.clear();
+            integrateTables_.clear();
+            uint32_t count = 0;
+            while (it.next()) {
+                IntegrateTable table;
+                table.transforms = &it.field<E_Transform>(0)[0];
+                table.velocities = &it.field<E_Velocity>(1)[0];
+                table.gravity = it.is_set(2) ? &it.field<const E_Gravity>(2)[0] : nullptr;
+                table.first = count;
+                count += (uint32_t)it.count();
+                integrateTables_.push_back(table);
+            }
+            integrate(it.delta_time(), count);
+        });
 
-            float dt = it.delta_time();
+    // --------------------------------------------------------
+    // Static colliders: persistent tree, patched on set/remove only
+    // --------------------------------------------------------
+    staticSync_ = world.observer<E_Transform, E_Collider>("StaticColliderSync")
+        .event(flecs::OnSet)
+        .event(flecs::OnRemove)
+        .each([this](flecs::iter& it, size_t i, E_Transform& t, E_Collider& c) {
+            flecs::entity e = it.entity(i);
+            if (it.event() == flecs::OnRemove) {
+                removeStaticBody(e.id());
+                if (e.has<E_Asleep>()) e.remove<E_Asleep>();
+                return;
+            }
+            syncStaticCollider(e, t, c);
+        });
 
-            qColliders_.each([&](flecs::entity e, E_Transform& t, E_Collider& c) {
-                if (!c.active) return; // Skip inactive colliders
-
-                float cx = t.x + c.offsetX;
-                float cy = t.y + c.offsetY;
-                
-                if (std::isnan(cx) || std::isnan(cy)) return;
-
-                float r = 0.0f;
-                if (c.type == ColliderType::Circle) {
-                    r = c.radius;
-                } else {
-                    float hx = c.width * 0.5f;
-                    float hy = c.height * 0.5f;
-                    r = std::sqrt(hx*hx + hy*hy);
-                }
-                
-                Vec2 vel = {0, 0};
-                const E_Velocity* v = e.has<E_Velocity>() ? &e.get<E_Velocity>() : nullptr;
-                if (v) vel = {v->vx, v->vy};
-
-                bool isBig = (r > (float)CELL_SIZE * 3.0f);
-                if (isBig) {
-                    bigBodies_.push_back(e.id());
-                }
+    tileMapSync_ = world.observer<E_Transform, E_TileMap>("TileMapSync")
+        .event(flecs::OnSet)
+        .event(flecs::OnRemove)
+        .each([this](flecs::iter& it, size_t i, E_Transform& t, E_TileMap& map) {
+            flecs::entity e = it.entity(i);
+            if (it.event() == flecs::OnRemove) removeTileMap(e.id());
+            else buildTileMap(e, t, map);
+        });
 
-                float vx = vel.x * dt;
-                float vy = vel.y * dt;
-                float minX = cx - r + std::fmin(0.0f, vx);
-                float maxX = cx + r + std::fmax(0.0f, vx);
-                float minY = cy - r + std::fmin(0.0f, vy);
-                float maxY = cy + r + std::fmax(0.0f, vy);
-
-                int cMinX = (int)floorf(minX / (float)CELL_SIZE);
-                int cMaxX = (int)floorf(maxX / (float)CELL_SIZE);
-                int cMinY = (int)floorf(minY / (float)CELL_SIZE);
-                int cMaxY = (int)floorf(maxY / (float)CELL_SIZE);
-                
-                if (cMaxX - cMinX > 100 || cMaxY - cMinY > 100) { 
-                     grid_[hashCellGlobal((int)(cx/CELL_SIZE), (int)(cy/CELL_SIZE))].push_back(e.id());
-                     return;
-                }
+    // writing E_Velocity wakes a sleeping body (E_Transform goes through StaticColliderSync)
+    wakeSync_ = world.observer<E_Velocity>("WakeOnVelocitySet")
+        .with<E_Asleep>()
+        .event(flecs::OnSet)
+        .each([this](flecs::iter& it, size_t i, E_Velocity&) {
+            wake(it.entity(i));
+        });
 
-                for (int x = cMinX; x <= cMaxX; ++x) {
-                    for (int y = cMinY; y <= cMaxY; ++y) {
-                         grid_[hashCellGlobal(x, y)].push_back(e.id());
-                    }
-                }
-            });
+    // sprites with E_Clickable/E_EffectHover: pick tree, patched on set/remove.
+    // Moving ones (E_Velocity) are refreshed every frame by ClickableSystem
+    pickSync_ = world.observer<E_Transform, E_Sprite>("PickableSync")
+        .with<E_Clickable>().or_()
+        .with<E_EffectHover>()
+        .event(flecs::OnSet)
+        .event(flecs::OnRemove)
+        .each([this](flecs::iter& it, size_t i, E_Transform& t, E_Sprite& s) {
+            flecs::entity e = it.entity(i);
+            if (it.event() == flecs::OnRemove) {
+                // losing one of the two pickable components keeps it pickable
+                flecs::world w = it.world();
+                bool other = (it.event_id() == w.id<E_Clickable>() && e.has<E_EffectHover>())
+                          || (it.event_id() == w.id<E_EffectHover>() && e.has<E_Clickable>());
+                if (!other) removePickable(e.id());
+                return;
+            }
+            syncPickable(e, t, s);
         });
 
     // --------------------------------------------------------
-    // System 2: Collision & Resolve (OnUpdate)
+    // Collision (fixed step, after IntegrateSystem)
+    //   1. snapshot of moving colliders          (serial, flecs access)
+    //   2. broadphase build                      (grid: per-thread binning)
+    //   3. candidate pairs                       (serial)
+    //   4. narrowphase -> per-thread contacts     (parallel, read-only)
+    //      trigger overlaps -> enter/exit events  (serial)
+    //   5. resolve in entity-pair order           (serial, deterministic)
+    //   6. islands -> sleep                       (serial)
+    //   7. collision callbacks                    (serial, events of step 5)
     // --------------------------------------------------------
-    world.system<E_Transform, E_Collider>("CollisionSystem")
-        .kind(flecs::OnUpdate)
-        .run([this, &aabbHalfExtents](flecs::iter& it) {
-            while (it.next()) {
-                auto tArr = it.field<E_Transform>(0);
-                auto cArr = it.field<E_Collider>(1);
-
-                for (auto i : it) {
-                    flecs::entity eA = it.entity(i);
-                    E_Transform& tA = tArr[i];
-                    E_Collider&  cA = cArr[i];
-
-                    if (!cA.active) continue;
-
-                    auto tryMarkPair = [&](flecs::entity_t a, flecs::entity_t b) -> bool {
-                        if (a == b) return false;
-                        if (a > b) std::swap(a, b);
-                        return testedPairs_.insert(PairKey{a, b}).second;
-                    };
-
-                    auto resolvePair = [&](flecs::entity eA, E_Transform& tA, E_Collider& cA,
-                                           flecs::entity eB, E_Transform& tB, E_Collider& cB) {
-                        
-                        if (cA.layer != cB.layer) return;
-                        if (!cA.active || !cB.active) return;
-
-                        const float ax = tA.x + cA.offsetX;
-                        const float ay = tA.y + cA.offsetY;
-                        const float bx = tB.x + cB.offsetX;
-                        const float by = tB.y + cB.offsetY;
-
-                        auto halfA = (cA.type == ColliderType::Circle) ? Vec2{cA.radius, cA.radius}
-                                                                       : Vec2{cA.width * 0.5f, cA.height * 0.5f};
-                        auto halfB = (cB.type == ColliderType::Circle) ? Vec2{cB.radius, cB.radius}
-                                                                       : Vec2{cB.width * 0.5f, cB.height * 0.5f};
-
-                        if (std::abs(ax - bx) > (halfA.x + halfB.x)) return;
-                        if (std::abs(ay - by) > (halfA.y + halfB.y)) return;
-
-                        Vec2 mtv = {0, 0};
-                        bool collided = false;
-
-                        const bool polyA = (cA.type == ColliderType::Rect || cA.type == ColliderType::Triangle);
-                        const bool polyB = (cB.type == ColliderType::Rect || cB.type == ColliderType::Triangle);
-                        const bool circleA = (cA.type == ColliderType::Circle);
-                        const bool circleB = (cB.type == ColliderType::Circle);
-
-                        if (polyA && polyB) {
-                            PolyVerts vA = getVertices(tA, cA);
-                            PolyVerts vB = getVertices(tB, cB);
-                            collided = satPolyPoly(vA.data, vA.count, vB.data, vB.count, mtv);
-                        }
-                        else if (circleA && circleB) {
-                            collided = satCircleCircle({ax, ay}, cA.radius, {bx, by}, cB.radius, mtv);
-                        }
-                        else if (circleA && polyB) {
-                            PolyVerts vB = getVertices(tB, cB);
-                            Vec2 mtvTemp = {0, 0};
-                            if (satCirclePoly({ax, ay}, cA.radius, vB.data, vB.count, mtvTemp)) {
-                                collided = true;
-                                mtv = mul(mtvTemp, -1.0f);
-                            }
-                        }
-                        else if (polyA && circleB) {
-                            PolyVerts vA = getVertices(tA, cA);
-                            collided = satCirclePoly({bx, by}, cB.radius, vA.data, vA.count, mtv);
-                        }
-
-                        if (!collided) return;
-                        
-                        bool isSensor = cA.isTrigger || cB.isTrigger;
-                        it.world().entity().set<E_CollisionEvent>({eA, eB, isSensor});
-                        
-                        if (isSensor) return;
-
-                        float invMassA = 1.0f;
-                        float invMassB = 1.0f;
-
-                        if (eA.has<E_Mass>()) invMassA = eA.get<E_Mass>().invMass;
-                        else if (cA.isStatic) invMassA = 0.0f;
-
-                        if (eB.has<E_Mass>()) invMassB = eB.get<E_Mass>().invMass;
-                        else if (cB.isStatic) invMassB = 0.0f;
-
-                        if (invMassA == 0.0f && invMassB == 0.0f) return;
-
-                        float totalInvMass = invMassA + invMassB;
-                        if (totalInvMass <= 0.0f) return;
-
-                        tA.x -= mtv.x * (invMassA / totalInvMass);
-                        tA.y -= mtv.y * (invMassA / totalInvMass);
-
-                        tB.x += mtv.x * (invMassB / totalInvMass);
-                        tB.y += mtv.y * (invMassB / totalInvMass);
-
-                        Vec2 n = normalize(mtv);
-                        if (lenSq(n) < 1e-8f) return;
-
-                        E_Velocity* vA = eA.has<E_Velocity>() ? &eA.get_mut<E_Velocity>() : nullptr;
-                        E_Velocity* vB = eB.has<E_Velocity>() ? &eB.get_mut<E_Velocity>() : nullptr;
-
-                        Vec2 velA = vA ? Vec2{vA->vx, vA->vy} : Vec2{0, 0};
-                        Vec2 velB = vB ? Vec2{vB->vx, vB->vy} : Vec2{0, 0};
-
-                        Vec2 relVel = sub(velB, velA);
-                        float velAlongNormal = dot(relVel, n);
-
-                        if (velAlongNormal > 0.0f) return;
-
-                        float e = 0.3f;
-                        if (eA.has<E_PhysicsMaterial>() && eB.has<E_PhysicsMaterial>()) {
-                            float resA = eA.get<E_PhysicsMaterial>().restitution;
-                            float resB = eB.get<E_PhysicsMaterial>().restitution;
-                            e = (resA + resB) * 0.5f;
-                        }
-
-                        float j = -(1.0f + e) * velAlongNormal / totalInvMass;
-                        Vec2 impulse = mul(n, j);
-
-                        if (vA && invMassA > 0.0f) {
-                            vA->vx -= impulse.x * invMassA;
-                            vA->vy -= impulse.y * invMassA;
-                        }
-                        if (vB && invMassB > 0.0f) {
-                            vB->vx += impulse.x * invMassB;
-                            vB->vy += impulse.y * invMassB;
-                        }
-                    };
-
-                    // Pass A: Huge bodies
-                    for (flecs::entity_t idA : bigBodies_) {
-                        if (!it.world().is_alive(idA)) continue;
-                        flecs::entity eHuge = it.world().entity(idA);
-
-                        if (eHuge.has<E_Transform>() && eHuge.has<E_Collider>()) {
-                            E_Transform& tHuge = eHuge.get_mut<E_Transform>();
-                            E_Collider&  cHuge = eHuge.get_mut<E_Collider>();
-                            
-                            if(!cHuge.active) continue;
-
-                            qColliders_.each([&](flecs::entity eOther, E_Transform& tOther, E_Collider& cOther) {
-                                if (eOther.id() == idA) return;
-                                if (!tryMarkPair(idA, eOther.id())) return;
-                                resolvePair(eHuge, tHuge, cHuge, eOther, tOther, cOther);
-                            });
-                        }
-                    }
-
-                    // Pass B: Grid
-                    float cx = tA.x + cA.offsetX;
-                    float cy = tA.y + cA.offsetY;
-                    Vec2 half = aabbHalfExtents(cA);
-
-                    Vec2 vel = {0,0};
-                    if (eA.has<E_Velocity>()) {
-                        E_Velocity& v = eA.get_mut<E_Velocity>();
-                        vel = {v.vx, v.vy};
-                    }
-                    
-                    float dt = it.delta_time();
-                    float vx = vel.x * dt;
-                    float vy = vel.y * dt;
-
-                    float minX = cx - half.x + std::fmin(0.0f, vx);
-                    float maxX = cx + half.x + std::fmax(0.0f, vx);
-                    float minY = cy - half.y + std::fmin(0.0f, vy);
-                    float maxY = cy + half.y + std::fmax(0.0f, vy);
-
-                    int cellMinX = (int)floorf(minX / (float)CELL_SIZE);
-                    int cellMaxX = (int)floorf(maxX / (float)CELL_SIZE);
-                    int cellMinY = (int)floorf(minY / (float)CELL_SIZE);
-                    int cellMaxY = (int)floorf(maxY / (float)CELL_SIZE);
-
-                    for (int x = cellMinX; x <= cellMaxX; ++x)
-                    for (int y = cellMinY; y <= cellMaxY; ++y) {
-                        long long key = hashCellGlobal(x, y);
-                        if (grid_.find(key) == grid_.end()) continue;
-
-                        for (flecs::entity_t idB : grid_[key]) {
-                            if (!tryMarkPair(eA.id(), idB)) continue;
-                            if (!it.world().is_alive(idB)) continue;
-
-                            flecs::entity eB = it.world().entity(idB);
-
-                            if (eB.has<E_Transform>() && eB.has<E_Collider>()) {
-                                E_Transform& tB = eB.get_mut<E_Transform>();
-                                E_Collider&  cB = eB.get_mut<E_Collider>();
-                                resolvePair(eA, tA, cA, eB, tB, cB);
-                            }
-                        }
-                    }
-                }
-            }
+    collisionSystem_ = world.system<>("CollisionSystem")
+        .kind(0)
+        .run([this](flecs::iter& it) {
+            flecs::world w = it.world();
+            float dt = it.delta_time();
+            size_t firstEvent = collisionEvents_.size();
+            StatsClock::time_point lap = StatsClock::now();
+
+            gatherBodies(dt);
+            stats_.gatherMs += lapMs(lap);
+            buildBroadphase();
+            findCandidatePairs();
+            stats_.broadphaseMs += lapMs(lap);
+            runNarrowphase();
+            stats_.narrowphaseMs += lapMs(lap);
+            updateTriggers(w);
+            resolveContacts(w);
+            stats_.solveMs += lapMs(lap);
+            updateSleep(w, dt);
+            stats_.sleepMs += lapMs(lap);
+            dispatchCollisionCallbacks(firstEvent);
+            stats_.callbacksMs += lapMs(lap);
         });
     
     // --- Camera System ---
-    world.system<E_Transform, E_Camera>("CameraSystem")
+    flecs::system cameraSystem = world.system<E_Transform, E_Camera>("CameraSystem")
         .each([](flecs::entity e, E_Transform& t, E_Camera& cam) {
             if (!cam.active) return;
 
@@ -349,37 +212,35 @@ void ECSWorld::init() {
         });
 
     // --- Clickable System ---
-    world.system<E_Transform, E_Sprite, E_Clickable>("ClickableSystem")
-        .each([this](flecs::entity e, E_Transform& t, E_Sprite& s, E_Clickable& btn){
-            auto input = e.world().get_ref<E_InputState>();
-
-            bool hover = hoverIt(s,e,t); 
-
-            btn.isHovered = hover;
-            btn.isClicked = hover && input->leftPressed;
-
-            if (btn.isClicked && btn.onClick) {
-                btn.onClick();
-            }
+    // Mouse -> world once per frame, then a point query on pickTree_: only the
+    // sprites under the cursor (and the ones it just left) are touched
+    world.system<>("ClickableSystem")
+        .run([this](flecs::iter& it) {
+            updatePicking(it.world());
         });
 
     // --- Render System ---
-    world.system<E_Transform, E_Sprite>("RenderSystem")
+    flecs::system renderSystem = world.system<E_Transform, E_Sprite>("RenderSystem")
         .each([this](flecs::entity e, E_Transform& t, E_Sprite& sprite) {
             const E_Color* color = e.has<E_Color>() ? &e.get<E_Color>() : nullptr;
             const E_Texture* tex = e.has<E_Texture>() ? &e.get<E_Texture>() : nullptr;
             const E_EffectShadow* shadow = e.has<E_EffectShadow>() ? &e.get<E_EffectShadow>() : nullptr;
             const E_EffectOutline* outline = e.has<E_EffectOutline>() ? &e.get<E_EffectOutline>() : nullptr;
             const E_EffectTranspare* trans = e.has<E_EffectTranspare>() ? &e.get<E_EffectTranspare>() : nullptr;
-            const E_EffectHover* hover = e.has<E_EffectHover>() ? &e.get<E_EffectHover>() : nullptr;
-
-            if(hover) {
-                hoverIt(sprite, e, t);
+            const E_PrevTransform* prev = e.has<E_PrevTransform>() ? &e.get<E_PrevTransform>() : nullptr;
+
+            // physics runs at a fixed rate, draw between its last two steps
+            float x = t.x, y = t.y, angle = t.angle;
+            if (prev) {
+                float a = getInterpolationAlpha();
+                x = prev->x + (t.x - prev->x) * a;
+                y = prev->y + (t.y - prev->y) * a;
+                angle = prev->angle + (t.angle - prev->angle) * a;
             }
 
             glPushMatrix();
-            glTranslatef(t.x, t.y, t.layer);
-            glRotatef(t.angle, 0.f, 0.f, 1.f);
+            glTranslatef(x, y, t.layer);
+            glRotatef(angle, 0.f, 0.f, 1.f);
             glScalef(t.xScale, t.yScale, 1.f);
 
             float alpha = (trans && trans->work) ? trans->alpha : 1.f;
@@ -425,22 +286,1559 @@ void ECSWorld::init() {
 
             glPopMatrix();
         });
-    
-    // --- Post Update: Clear Events ---
-    world.system<E_CollisionEvent>("ClearCollisionEvents")
-        .kind(flecs::PostUpdate)
-        .each([](flecs::entity e, E_CollisionEvent&) {
-            e.destruct();
-        });
+
+    // headless: no GL context, the drawing systems stay out of the pipeline
+    headless_ = headless;
+    if (headless_) {
+        cameraSystem.disable();
+        renderSystem.disable();
+    }
 
     printf("[Engine] ECS world init done\n");
 }
 
 
+// Radius of the circle around the collider, used for the broadphase boxes
+float ECSWorld::boundingRadius(const E_Collider& c) {
+    if (c.type == ColliderType::Circle) return c.radius;
+    if (c.type == ColliderType::Polygon) {
+        const ConvexPolygon& poly = getPolygon(c.polygon);
+        return poly.count > 0 ? poly.radius : c.radius;
+    }
+    float hx = c.width * 0.5f;
+    float hy = c.height * 0.5f;
+    return std::sqrt(hx*hx + hy*hy);
+}
+
+// ================= Static colliders =================
+
+void ECSWorld::syncStaticCollider(flecs::entity e, const E_Transform& t, const E_Collider& c) {
+    if (!c.isStatic) {
+        removeStaticBody(e.id());
+        if (e.has<E_StaticCollider>()) e.remove<E_StaticCollider>();
+        if (e.has<E_Asleep>()) wake(e); // set<E_Transform> on a sleeping body
+        return;
+    }
+    if (e.has<E_Asleep>()) e.remove<E_Asleep>();
+
+    uint32_t slot = staticSlot(e.id());
+
+    float cx = t.x + c.offsetX;
+    float cy = t.y + c.offsetY;
+    float r = boundingRadius(c);
+
+    // static bodies are never pushed: no transform pointer, zero inverse mass
+    PhysicsBody& b = staticBodies_[slot];
+    b = PhysicsBody{};
+    b.id = e.id();
+    b.t = t;
+    b.c = c;
+    b.box = {cx - r, cy - r, cx + r, cy + r};
+    computeWorldShape(t, c, b.shape);
+    b.invMass = 0.0f;
+    if (e.has<E_PhysicsMaterial>()) {
+        const E_PhysicsMaterial& mat = e.get<E_PhysicsMaterial>();
+        b.restitution = mat.restitution;
+        b.friction = mat.friction;
+        b.hasMaterial = true;
+    }
+
+    staticTree_.update(e.id(), b.box, slot);
+
+    if (!e.has<E_StaticCollider>()) e.add<E_StaticCollider>();
+}
+
+uint32_t ECSWorld::staticSlot(flecs::entity_t id) {
+    auto found = staticSlots_.find(id);
+    if (found != staticSlots_.end()) return found->second;
+
+    uint32_t slot = allocateStaticSlot();
+    staticSlots_.emplace(id, slot);
+    return slot;
+}
+
+uint32_t ECSWorld::allocateStaticSlot() {
+    if (!freeStaticSlots_.empty()) {
+        uint32_t slot = freeStaticSlots_.back();
+        freeStaticSlots_.pop_back();
+        return slot;
+    }
+    staticBodies_.emplace_back();
+    return (uint32_t)staticBodies_.size() - 1;
+}
+
+void ECSWorld::removeStaticBody(flecs::entity_t id) {
+    auto found = staticSlots_.find(id);
+    if (found == staticSlots_.end()) return;
+
+    staticTree_.remove(id);
+    freeStaticSlots_.push_back(found->second);
+    staticSlots_.erase(found);
+}
+
+// ================= Tile maps =================
+
+void ECSWorld::buildTileMap(flecs::entity e, const E_Transform& t, const E_TileMap& map) {
+    removeTileMap(e.id());
+    if (map.width <= 0 || map.height <= 0 || map.chunkSize <= 0) return;
+    if ((int)map.solid.size() < map.width * map.height) {
+        printf("[Engine] E_TileMap: solid has %zu tiles, expected %d\n", map.solid.size(), map.width * map.height);
+        return;
+    }
+
+    TileMapBodies& bodies = tileMaps_[e.id()];
+    bodies.chunksX = (map.width + map.chunkSize - 1) / map.chunkSize;
+    bodies.chunksY = (map.height + map.chunkSize - 1) / map.chunkSize;
+    bodies.chunks.resize((size_t)bodies.chunksX * bodies.chunksY);
+
+    for (int cy = 0; cy < bodies.chunksY; ++cy)
+    for (int cx = 0; cx < bodies.chunksX; ++cx) {
+        buildTileChunk(e, t, map, cx, cy, bodies.chunks[(size_t)cy * bodies.chunksX + cx]);
+    }
+}
+
+// Greedy meshing: the first free solid tile (row by row) grows right as far as
+// it can, then down while the whole row below is solid. Every tile ends up in
+// exactly one rect, a chunk holds at most chunkSize^2 / 2 rects (checkerboard)
+void ECSWorld::buildTileChunk(flecs::entity e, const E_Transform& t, const E_TileMap& map,
+                              int chunkX, int chunkY, std::vector<uint32_t>& slots) {
+    for (uint32_t slot : slots) {
+        staticTree_.remove(TILE_PROXY_BIT | slot);
+        freeStaticSlots_.push_back(slot);
+    }
+    slots.clear();
+
+    const int x0 = chunkX * map.chunkSize, x1 = std::min(x0 + map.chunkSize, map.width);
+    const int y0 = chunkY * map.chunkSize, y1 = std::min(y0 + map.chunkSize, map.height);
+    const int w = x1 - x0;
+
+    tileUsed_.assign((size_t)w * (y1 - y0), 0);
+    auto isFree = [&](int x, int y) {
+        return map.solid[(size_t)y * map.width + x] && !tileUsed_[(size_t)(y - y0) * w + (x - x0)];
+    };
+
+    const E_PhysicsMaterial* mat = e.has<E_PhysicsMaterial>() ? &e.get<E_PhysicsMaterial>() : nullptr;
+
+    for (int y = y0; y < y1; ++y)
+    for (int x = x0; x < x1; ++x) {
+        if (!isFree(x, y)) continue;
+
+        int rx = x + 1;
+        while (rx < x1 && isFree(rx, y)) ++rx;
+        int ry = y + 1;
+        for (; ry < y1; ++ry) {
+            int i = x;
+            while (i < rx && isFree(i, ry)) ++i;
+            if (i < rx) break;
+        }
+        for (int j = y; j < ry; ++j)
+        for (int i = x; i < rx; ++i) {
+            tileUsed_[(size_t)(j - y0) * w + (i - x0)] = 1;
+        }
+
+        uint32_t slot = allocateStaticSlot();
+        slots.push_back(slot);
+
+        const float width = (rx - x) * map.tileSize;
+        const float height = (ry - y) * map.tileSize;
+        PhysicsBody& b = staticBodies_[slot];
+        b = PhysicsBody{};
+        b.id = e.id();
+        b.part = slot + 1;
+        b.t = {t.x + x * map.tileSize + width * 0.5f, t.y + y * map.tileSize + height * 0.5f, t.layer, 0.0f, 1.0f, 1.0f};
+        b.c.type = ColliderType::Rect;
+        b.c.width = width;
+        b.c.height = height;
+        b.c.isStatic = true;
+        b.c.layer = map.layer;
+        b.c.mask = map.mask;
+        b.box = {b.t.x - width * 0.5f, b.t.y - height * 0.5f, b.t.x + width * 0.5f, b.t.y + height * 0.5f};
+        computeWorldShape(b.t, b.c, b.shape);
+        b.invMass = 0.0f;
+        if (mat) {
+            b.restitution = mat->restitution;
+            b.friction = mat->friction;
+            b.hasMaterial = true;
+        }
+
+        staticTree_.update(TILE_PROXY_BIT | slot, b.box, slot);
+    }
+}
+
+void ECSWorld::removeTileMap(flecs::entity_t id) {
+    auto found = tileMaps_.find(id);
+    if (found == tileMaps_.end()) return;
+
+    for (const auto& chunk : found->second.chunks)
+    for (uint32_t slot : chunk) {
+        staticTree_.remove(TILE_PROXY_BIT | slot);
+        freeStaticSlots_.push_back(slot);
+    }
+    tileMaps_.erase(found);
+}
+
+void ECSWorld::setTile(flecs::entity e, int x, int y, bool solid) {
+    E_TileMap* map = e.is_alive() ? e.try_get_mut<E_TileMap>() : nullptr;
+    if (!map || x < 0 || y < 0 || x >= map->width || y >= map->height) return;
+    if ((int)map->solid.size() < map->width * map->height) return;
+
+    uint8_t& tile = map->solid[(size_t)y * map->width + x];
+    if ((tile != 0) == solid) return;
+    tile = solid ? 1 : 0;
+
+    auto found = tileMaps_.find(e.id());
+    if (found == tileMaps_.end() || !e.has<E_Transform>()) return;
+    TileMapBodies& bodies = found->second;
+    int cx = x / map->chunkSize, cy = y / map->chunkSize;
+    buildTileChunk(e, e.get<E_Transform>(), *map, cx, cy, bodies.chunks[(size_t)cy * bodies.chunksX + cx]);
+}
+
+void ECSWorld::moveStaticCollider(flecs::entity e) {
+    if (!e.is_alive() || !e.has<E_Transform>() || !e.has<E_Collider>()) return;
+    syncStaticCollider(e, e.get<E_Transform>(), e.get<E_Collider>());
+}
+
+// ================= Collision pipeline =================
+
+void ECSWorld::setBroadphaseMode(BroadphaseMode mode) {
+    if (mode == broadphaseMode_) return;
+    broadphaseMode_ = mode;
+
+    // structures of the other mode are rebuilt from scratch when switched back
+    grid_.clear();
+    sap_.clear();
+    for (AabbTree& tree : trees_) tree.clear();
+}
+
+size_t ECSWorld::getGridCells(std::vector<GridCellStat>& out) const {
+    if (broadphaseMode_ != BroadphaseMode::Grid) return 0;
+    const size_t first = out.size();
+    for (uint32_t c = 0; c < grid_.cellCount(); ++c) {
+        const uint64_t key = grid_.keyAt(c);
+        const int level = cellKeyLevel(key);
+        const float cs = cellSize(level);
+        out.push_back({cellKeyX(key) * cs, cellKeyY(key) * cs, cs, grid_.cellAt(c).count, cellKeyLayer(key), level});
+    }
+    return out.size() - first;
+}
+
+void ECSWorld::setLayerCollision(int layerA, int layerB, bool collide) {
+    layerA &= MAX_LAYERS - 1;
+    layerB &= MAX_LAYERS - 1;
+    if (collide) {
+        layerMatrix_[layerA] |= layerBit(layerB);
+        layerMatrix_[layerB] |= layerBit(layerA);
+    } else {
+        layerMatrix_[layerA] &= ~layerBit(layerB);
+        layerMatrix_[layerB] &= ~layerBit(layerA);
+    }
+}
+
+void ECSWorld::setPhysicsThreads(unsigned threads) {
+    jobs_.setThreadCount(threads);
+}
+
+void ECSWorld::gatherBodies(float dt) {
+    bodies_.clear();
+    for (uint32_t& layers : levelLayers_) layers = 0;
+    for (uint32_t layers = activeLayers_; layers; layers &= layers - 1) {
+        layerBodies_[__builtin_ctz(layers)].clear();
+    }
+    activeLayers_ = 0;
+
+    qDynamic_.each([&](flecs::entity e, E_Transform& t, E_Collider& c,
+                       E_Velocity* v, E_Mass* m, E_PhysicsMaterial* mat, E_Sleep* sleep,
+                       const E_PrevTransform* prev) {
+        if (!c.active) return; // Skip inactive colliders
+
+        float cx = t.x + c.offsetX;
+        float cy = t.y + c.offsetY;
+        if (std::isnan(cx) || std::isnan(cy)) return;
+
+        PhysicsBody b;
+        b.id = e.id();
+        b.transform = &t;
+        b.velocity = v;
+        b.sleep = sleep;
+        if (!sleep && sleepEnabled_) e.add<E_Sleep>(); // deferred, timer starts next frame
+        b.t = t;
+        b.c = c;
+        b.invMass = m ? m->invMass : 1.0f;
+        if (mat) {
+            b.restitution = mat->restitution;
+            b.friction = mat->friction;
+            b.hasMaterial = true;
+        }
+        if (v) {
+            b.vx = v->vx;
+            b.vy = v->vy;
+        }
+
+        // box covers the whole move of this frame (IntegrateSystem already ran)
+        float r = boundingRadius(c);
+        float vx = v ? v->vx * dt : 0.0f;
+        float vy = v ? v->vy * dt : 0.0f;
+        if (c.isBullet && prev) {
+            b.bullet = true;
+            b.dx = vx = t.x - prev->x;
+            b.dy = vy = t.y - prev->y;
+        }
+        b.box = { cx - r - std::fmax(0.0f, vx), cy - r - std::fmax(0.0f, vy),
+                  cx + r - std::fmin(0.0f, vx), cy + r - std::fmin(0.0f, vy) };
+
+        if (!std::isfinite(b.box.minX + b.box.minY + b.box.maxX + b.box.maxY)) return;
+
+        // grid level: the smallest cells that still fit the box, so a body covers
+        // at most 2x2 cells of its level. Only the top level has no size limit
+        const float extent = std::fmax(b.box.maxX - b.box.minX, b.box.maxY - b.box.minY);
+        int level = 0;
+        while (level < MAX_GRID_LEVELS - 1 && extent > cellSize(level)) ++level;
+        b.gridLevel = (uint8_t)level;
+
+        const int layer = c.layer & (MAX_LAYERS - 1);
+        activeLayers_ |= layerBit(layer);
+        levelLayers_[level] |= layerBit(layer);
+        layerBodies_[layer].push_back((uint32_t)bodies_.size());
+        dynamicBounds_ = bodies_.empty() ? b.box : Aabb::combine(dynamicBounds_, b.box);
+        bodies_.push_back(b);
+    });
+
+    // world-space vertices/axes once per body, the narrowphase only reads them
+    jobs_.parallelFor((uint32_t)bodies_.size(), 256, [&](uint32_t begin, uint32_t end, unsigned) {
+        for (uint32_t i = begin; i < end; ++i) {
+            computeWorldShape(bodies_[i].t, bodies_[i].c, bodies_[i].shape);
+        }
+    });
+}
+
+void ECSWorld::buildBroadphase() {
+    const uint32_t count = (uint32_t)bodies_.size();
+    stats_.bodies = count;
+    stats_.staticBodies = (uint32_t)(staticBodies_.size() - freeStaticSlots_.size());
+    if (broadphaseMode_ != BroadphaseMode::Grid) {
+        stats_.occupiedCells = stats_.gridEntries = stats_.maxPerCell = 0;
+        stats_.avgPerCell = 0.0f;
+        for (uint32_t& cells : stats_.cellsPerLevel) cells = 0;
+    }
+
+    switch (broadphaseMode_) {
+        case BroadphaseMode::Grid: {
+            grid_.clear();
+            grid_.setPartCount(jobs_.threadCount());
+
+            // per-thread binning, build() merges the parts with one counting sort
+            jobs_.parallelFor(count, 256, [&](uint32_t begin, uint32_t end, unsigned worker) {
+                for (uint32_t i = begin; i < end; ++i) {
+                    const Aabb& box = bodies_[i].box;
+                    const int level = bodies_[i].gridLevel;
+                    const float cs = cellSize(level);
+
+                    int cMinX = (int)floorf(box.minX / cs);
+                    int cMaxX = (int)floorf(box.maxX / cs);
+                    int cMinY = (int)floorf(box.minY / cs);
+                    int cMaxY = (int)floorf(box.maxY / cs);
+
+                    // layer and level are part of the key: one partition per layer and level
+                    const int layer = bodies_[i].c.layer;
+                    for (int x = cMinX; x <= cMaxX; ++x)
+                    for (int y = cMinY; y <= cMaxY; ++y) {
+                        grid_.insert(worker, hashCellGlobal(x, y, layer, level), i);
+                    }
+                }
+            });
+
+            grid_.build();
+
+            stats_.occupiedCells = grid_.cellCount();
+            stats_.gridEntries = grid_.entryCount();
+            stats_.avgPerCell = stats_.occupiedCells ? (float)stats_.gridEntries / (float)stats_.occupiedCells : 0.0f;
+            stats_.maxPerCell = 0;
+            for (uint32_t& cells : stats_.cellsPerLevel) cells = 0;
+            for (uint32_t c = 0; c < grid_.cellCount(); ++c) {
+                stats_.maxPerCell = std::max(stats_.maxPerCell, grid_.cellAt(c).count);
+                ++stats_.cellsPerLevel[cellKeyLevel(grid_.keyAt(c))];
+            }
+            break;
+        }
+        case BroadphaseMode::SweepAndPrune: {
+            sap_.beginFrame();
+            for (uint32_t i = 0; i < count; ++i) sap_.update(bodies_[i].id, bodies_[i].box, i);
+            sap_.endFrame();
+            break;
+        }
+        case BroadphaseMode::AabbTree: {
+            // one tree per layer. The trees keep fat boxes, no re-insert while
+            // the body stays inside. Trees of emptied layers drop their proxies too
+            for (int layer = 0; layer < MAX_LAYERS; ++layer) {
+                AabbTree& tree = trees_[layer];
+                if (tree.proxyCount() == 0 && layerBodies_[layer].empty()) continue;
+                tree.beginFrame();
+                for (uint32_t i : layerBodies_[layer]) tree.update(bodies_[i].id, bodies_[i].box, i);
+                tree.endFrame();
+            }
+            break;
+        }
+    }
+}
+
+// Lower entity id first. Which side a body lands on decides the MTV sign, the
+// kernel path and the event orientation, so it can't be left to the order the
+// workers happened to bin or visit the bodies in
+static BodyPair orderedPair(const std::vector<PhysicsBody>& bodies, uint32_t a, uint32_t b) {
+    return bodies[a].id < bodies[b].id ? BodyPair{a, b} : BodyPair{b, a};
+}
+
+void ECSWorld::findCandidatePairs() {
+    pairs_.clear();
+    if (threadCounters_.size() < jobs_.threadCount()) threadCounters_.resize(jobs_.threadCount(), WorkerCounters{});
+
+    // sweep and prune has no partitions, other layers are dropped right here
+    if (broadphaseMode_ == BroadphaseMode::SweepAndPrune) {
+        sap_.findPairs([&](uint32_t a, uint32_t b) {
+            if (canCollide(bodies_[a].c, bodies_[b].c)) pairs_.push_back(orderedPair(bodies_, a, b));
+        });
+        return;
+    }
+
+    if (broadphaseMode_ == BroadphaseMode::AabbTree) {
+        for (uint32_t layers = activeLayers_; layers; layers &= layers - 1) {
+            const int layer = __builtin_ctz(layers);
+
+            // pairs inside the layer
+            if (layerMatrix_[layer] & layerBit(layer)) {
+                trees_[layer].findPairs([&](uint32_t a, uint32_t b) {
+                    if (!bodies_[a].box.overlaps(bodies_[b].box)) return; // fat leaves
+                    if (canCollide(bodies_[a].c, bodies_[b].c)) pairs_.push_back(orderedPair(bodies_, a, b));
+                });
+            }
+            // pairs with higher layers: bodies of this layer query the other tree
+            uint32_t others = layerMatrix_[layer] & activeLayers_ & ~((layerBit(layer) << 1) - 1);
+            for (; others; others &= others - 1) {
+                const AabbTree& other = trees_[__builtin_ctz(others)];
+                for (uint32_t i : layerBodies_[layer]) {
+                    other.query(bodies_[i].box, [&](uint32_t j) {
+                        if (!bodies_[i].box.overlaps(bodies_[j].box)) return;
+                        if (canCollide(bodies_[i].c, bodies_[j].c)) pairs_.push_back(orderedPair(bodies_, i, j));
+                    });
+                }
+            }
+        }
+        return;
+    }
+
+    // Grid, cells in parallel.
+    // No dedup set: a pair is only reported by the cell that holds the min corner
+    // of the two boxes' overlap. Both boxes cover that cell, so it is always found.
+    // Layers have their own cells: a cell pairs with itself if its layer
+    // self-collides and with the same cell of higher layers it collides with.
+    // Levels too: a cell pairs with the cells of coarser levels that contain it,
+    // ownership goes by the finer cell. Cell sizes are powers of two, so the
+    // parent cell (x >> 2 per level) is exactly the one the division gives
+    const unsigned threads = jobs_.threadCount();
+    if (threadPairs_.size() < threads) threadPairs_.resize(threads);
+    for (auto& list : threadPairs_) list.clear();
+
+    jobs_.parallelFor(grid_.cellCount(), 64, [&](uint32_t begin, uint32_t end, unsigned worker) {
+        std::vector<BodyPair>& out = threadPairs_[worker];
+        uint64_t tested = 0, rejects = 0, duplicates = 0;
+
+        auto testPair = [&](uint32_t i, uint32_t j, int cellX, int cellY, float cs) {
+            const Aabb& a = bodies_[i].box;
+            const Aabb& b = bodies_[j].box;
+            ++tested;
+            if (!a.overlaps(b)) { ++rejects; return; }
+
+            float ox = a.minX > b.minX ? a.minX : b.minX;
+            float oy = a.minY > b.minY ? a.minY : b.minY;
+            if ((int)floorf(ox / cs) != cellX || (int)floorf(oy / cs) != cellY) { ++duplicates; return; }
+
+            if (!canCollide(bodies_[i].c, bodies_[j].c)) return; // masks
+            out.push_back(orderedPair(bodies_, i, j));
+        };
+
+        for (uint32_t c = begin; c < end; ++c) {
+            FlatGrid::Cell cell = grid_.cellAt(c);
+
+            const uint64_t key = grid_.keyAt(c);
+            const int cellX = cellKeyX(key);
+            const int cellY = cellKeyY(key);
+            const int layer = cellKeyLayer(key);
+            const int level = cellKeyLevel(key);
+            const float cs = cellSize(level);
+
+            if (cell.count >= 2 && (layerMatrix_[layer] & layerBit(layer))) {
+                for (uint32_t p = 0; p < cell.count; ++p)
+                for (uint32_t q = p + 1; q < cell.count; ++q) {
+                    testPair(cell.data[p], cell.data[q], cellX, cellY, cs);
+                }
+            }
+
+            uint32_t others = layerMatrix_[layer] & levelLayers_[level] & ~((layerBit(layer) << 1) - 1);
+            for (; others; others &= others - 1) {
+                FlatGrid::Cell other = grid_.cell(hashCellGlobal(cellX, cellY, __builtin_ctz(others), level));
+                for (uint32_t i : cell)
+                for (uint32_t j : other) {
+                    testPair(i, j, cellX, cellY, cs);
+                }
+            }
+
+            // coarser levels, every layer this one collides with
+            for (int up = level + 1; up < MAX_GRID_LEVELS; ++up) {
+                const int shift = 2 * (up - level);
+                for (uint32_t l = layerMatrix_[layer] & levelLayers_[up]; l; l &= l - 1) {
+                    FlatGrid::Cell other = grid_.cell(hashCellGlobal(cellX >> shift, cellY >> shift, __builtin_ctz(l), up));
+                    for (uint32_t i : cell)
+                    for (uint32_t j : other) {
+                        testPair(i, j, cellX, cellY, cs);
+                    }
+                }
+            }
+        }
+
+        WorkerCounters& counters = threadCounters_[worker];
+        counters.cellPairs += tested;
+        counters.aabbRejects += rejects;
+        counters.duplicatePairs += duplicates;
+    });
+
+    for (const auto& list : threadPairs_) pairs_.insert(pairs_.end(), list.begin(), list.end());
+}
+
+// Narrowphase for one pair, read-only. mtv pushes B out of A
+static bool collideBodies(const PhysicsBody& A, const PhysicsBody& B, Vec2& mtv) {
+    const E_Collider& cA = A.c;
+    const E_Collider& cB = B.c;
+
+    if (!cA.active || !cB.active) return false;
+
+    const WorldShape& sA = A.shape;
+    const WorldShape& sB = B.shape;
+
+    const float rSum = sA.radius + sB.radius;
+    if (std::abs(sA.cx - sB.cx) > rSum) return false;
+    if (std::abs(sA.cy - sB.cy) > rSum) return false;
+
+    // pool polygons: GJK/EPA, cost grows with the vertex count only
+    if (sA.hull || sB.hull) {
+        return gjkShapeShape(sA, sB, mtv);
+    }
+
+    const bool polyA = sA.count > 0;
+    const bool polyB = sB.count > 0;
+    const bool circleA = !polyA;
+    const bool circleB = !polyB;
+
+    if (polyA && polyB) {
+        return satShapeShape(sA, sB, mtv);
+    }
+    if (circleA && circleB) {
+        return satCircleCircle({sA.cx, sA.cy}, sA.radius, {sB.cx, sB.cy}, sB.radius, mtv);
+    }
+    if (circleA && polyB) {
+        Vec2 mtvTemp = {0, 0};
+        if (!satCircleShape({sA.cx, sA.cy}, sA.radius, sB, mtvTemp)) return false;
+        mtv = mul(mtvTemp, -1.0f);
+        return true;
+    }
+    if (polyA && circleB) {
+        return satCircleShape({sB.cx, sB.cy}, sB.radius, sA, mtv);
+    }
+    return false;
+}
+
+// Shape-pair buckets with a batched kernel. Rotated rects and triangles
+// stay on the scalar SAT path
+static bool isAxisAlignedRect(const PhysicsBody& b) {
+    return b.c.type == ColliderType::Rect && b.t.angle == 0.0f;
+}
+
+static void pushContact(std::vector<Contact>& out, const PhysicsBody& A, uint32_t a,
+                        const PhysicsBody& B, uint32_t b, bool staticB, float mtvX, float mtvY) {
+    Contact ct;
+    ct.lo = A.id < B.id ? A.id : B.id;
+    ct.hi = A.id < B.id ? B.id : A.id;
+    ct.part = B.part;
+    ct.bodyA = a;
+    ct.bodyB = b;
+    ct.staticB = staticB;
+    ct.isSensor = A.c.isTrigger || B.c.isTrigger;
+    ct.mtvX = mtvX;
+    ct.mtvY = mtvY;
+    out.push_back(ct);
+}
+
+void ECSWorld::runNarrowphase() {
+    const unsigned threads = jobs_.threadCount();
+    if (threadContacts_.size() < threads) threadContacts_.resize(threads);
+    for (auto& list : threadContacts_) list.clear();
+    if (threadImpacts_.size() < threads) threadImpacts_.resize(threads);
+    for (auto& list : threadImpacts_) list.clear();
+    while (threadBatches_.size() < threads) threadBatches_.push_back(std::make_unique<NarrowphaseBatches>());
+    if (threadTriggerTests_.size() < threads) threadTriggerTests_.resize(threads);
+    for (auto& list : threadTriggerTests_) list.clear();
+
+    // runs the kernel on a bucket and turns the hits into contacts
+    auto flush = [&](unsigned worker, ShapeBatch& batch, void (*kernel)(ShapeBatch&)) {
+        if (batch.count == 0) return;
+        kernel(batch);
+        threadCounters_[worker].batchedTests += batch.count;
+
+        for (uint32_t i = 0; i < batch.count; ++i) {
+            if (!batch.hit[i]) continue;
+            const bool staticB = batch.flags[i] & NarrowphaseBatches::StaticB;
+            const float sign = (batch.flags[i] & NarrowphaseBatches::Flipped) ? -1.0f : 1.0f;
+            const uint32_t a = batch.bodyA[i];
+            const uint32_t b = batch.bodyB[i];
+            pushContact(threadContacts_[worker], bodies_[a], a,
+                        staticB ? staticBodies_[b] : bodies_[b], b, staticB,
+                        batch.mtvX[i] * sign, batch.mtvY[i] * sign);
+        }
+        batch.clear();
+    };
+
+    auto flushAll = [&](unsigned worker) {
+        NarrowphaseBatches& nb = *threadBatches_[worker];
+        flush(worker, nb.circleCircle, batchCircleCircle);
+        flush(worker, nb.boxBox, batchBoxBox);
+        flush(worker, nb.circleBox, batchCircleBox);
+    };
+
+    // bullets: discrete test at the end pose, sweep if it missed
+    auto emitBullet = [&](unsigned worker, const PhysicsBody& A, uint32_t a,
+                          const PhysicsBody& B, uint32_t b, bool staticB) {
+        Vec2 mtv = {0, 0};
+        ++threadCounters_[worker].satTests;
+        if (collideBodies(A, B, mtv)) {
+            pushContact(threadContacts_[worker], A, a, B, b, staticB, mtv.x, mtv.y);
+            return;
+        }
+        if (A.c.isTrigger || B.c.isTrigger) return;
+
+        float t;
+        Vec2 n;
+        Vec2 d = {B.dx - A.dx, B.dy - A.dy};
+        if (timeOfImpact(A.shape, B.shape, d, t, n)) {
+            threadImpacts_[worker].push_back({a, b, staticB, t, n.x, n.y});
+        }
+    };
+
+    // triggers: last step's answer while neither body moved
+    auto emitTrigger = [&](unsigned worker, const PhysicsBody& A, uint32_t a,
+                           const PhysicsBody& B, uint32_t b, bool staticB) {
+        const bool aIsLo = A.id < B.id;
+        const PhysicsBody& L = aIsLo ? A : B;
+        const PhysicsBody& H = aIsLo ? B : A;
+        TriggerTest test;
+        test.lo = L.id;
+        test.hi = H.id;
+        test.part = B.part;
+        test.poseLo = {L.shape.cx, L.shape.cy, L.t.angle, L.shape.radius};
+        test.poseHi = {H.shape.cx, H.shape.cy, H.t.angle, H.shape.radius};
+
+        Vec2 mtv = {0, 0};
+        auto cached = std::lower_bound(triggerTests_.begin(), triggerTests_.end(), test);
+        if (cached != triggerTests_.end() && cached->lo == test.lo && cached->hi == test.hi &&
+            cached->part == test.part && cached->poseLo == test.poseLo && cached->poseHi == test.poseHi) {
+            test.overlap = cached->overlap;
+        } else {
+            ++threadCounters_[worker].satTests;
+            test.overlap = collideBodies(A, B, mtv);
+        }
+
+        threadTriggerTests_[worker].push_back(test);
+        if (test.overlap) pushContact(threadContacts_[worker], A, a, B, b, staticB, mtv.x, mtv.y);
+    };
+
+    auto emit = [&](unsigned worker, const PhysicsBody& A, uint32_t a,
+                    const PhysicsBody& B, uint32_t b, bool staticB) {
+        if (!canCollide(A.c, B.c)) return; // static pairs come unfiltered from the tree
+        if (!A.c.active || !B.c.active) return;
+
+        if (A.c.isTrigger || B.c.isTrigger) {
+            emitTrigger(worker, A, a, B, b, staticB);
+            return;
+        }
+
+        if (A.bullet || B.bullet) {
+            emitBullet(worker, A, a, B, b, staticB);
+            return;
+        }
+
+        NarrowphaseBatches& nb = *threadBatches_[worker];
+        const uint8_t flags = staticB ? NarrowphaseBatches::StaticB : 0;
+
+        const float ax = A.shape.cx, ay = A.shape.cy;
+        const float bx = B.shape.cx, by = B.shape.cy;
+        const bool circleA = A.c.type == ColliderType::Circle;
+        const bool circleB = B.c.type == ColliderType::Circle;
+
+        ShapeBatch* batch = nullptr;
+        void (*kernel)(ShapeBatch&) = nullptr;
+        uint32_t lane = 0;
+
+        if (circleA && circleB) {
+            batch = &nb.circleCircle;
+            kernel = batchCircleCircle;
+            lane = batch->push(ax, ay, A.c.radius, 0, bx, by, B.c.radius, 0);
+            batch->flags[lane] = flags;
+        } else if (isAxisAlignedRect(A) && isAxisAlignedRect(B)) {
+            batch = &nb.boxBox;
+            kernel = batchBoxBox;
+            lane = batch->push(ax, ay, A.c.width * 0.5f, A.c.height * 0.5f,
+                               bx, by, B.c.width * 0.5f, B.c.height * 0.5f);
+            batch->flags[lane] = flags;
+        } else if (circleA && isAxisAlignedRect(B)) {
+            batch = &nb.circleBox;
+            kernel = batchCircleBox;
+            lane = batch->push(ax, ay, A.c.radius, 0, bx, by, B.c.width * 0.5f, B.c.height * 0.5f);
+            batch->flags[lane] = flags;
+        } else if (isAxisAlignedRect(A) && circleB) {
+            // kernel wants the circle first, the MTV is negated back on flush
+            batch = &nb.circleBox;
+            kernel = batchCircleBox;
+            lane = batch->push(bx, by, B.c.radius, 0, ax, ay, A.c.width * 0.5f, A.c.height * 0.5f);
+            batch->flags[lane] = flags | NarrowphaseBatches::Flipped;
+        } else {
+            Vec2 mtv = {0, 0};
+            ++threadCounters_[worker].satTests;
+            if (collideBodies(A, B, mtv)) {
+                pushContact(threadContacts_[worker], A, a, B, b, staticB, mtv.x, mtv.y);
+            }
+            return;
+        }
+
+        batch->bodyA[lane] = a;
+        batch->bodyB[lane] = b;
+        if (batch->full()) flush(worker, *batch, kernel);
+    };
+
+    // dynamic vs dynamic
+    jobs_.parallelFor((uint32_t)pairs_.size(), 128, [&](uint32_t begin, uint32_t end, unsigned worker) {
+        for (uint32_t i = begin; i < end; ++i) {
+            const BodyPair& p = pairs_[i];
+            emit(worker, bodies_[p.a], p.a, bodies_[p.b], p.b, false);
+        }
+        flushAll(worker);
+        threadCounters_[worker].candidatePairs += end - begin;
+    });
+
+    // dynamic vs static. Static pairs with each other are never tested
+    jobs_.parallelFor((uint32_t)bodies_.size(), 64, [&](uint32_t begin, uint32_t end, unsigned worker) {
+        for (uint32_t i = begin; i < end; ++i) {
+            staticTree_.query(bodies_[i].box, [&](uint32_t slot) {
+                ++threadCounters_[worker].candidatePairs;
+                emit(worker, bodies_[i], i, staticBodies_[slot], slot, true);
+            });
+        }
+        flushAll(worker);
+    });
+
+    triggerTests_.clear();
+    for (const auto& list : threadTriggerTests_) triggerTests_.insert(triggerTests_.end(), list.begin(), list.end());
+    std::sort(triggerTests_.begin(), triggerTests_.end());
+
+    // merge, then sort by entity pair so the resolve order does not depend on threads
+    contacts_.clear();
+    for (const auto& list : threadContacts_) contacts_.insert(contacts_.end(), list.begin(), list.end());
+    resolveImpacts();
+    std::sort(contacts_.begin(), contacts_.end(), [](const Contact& x, const Contact& y) {
+        if (x.lo != y.lo) return x.lo < y.lo;
+        return x.hi != y.hi ? x.hi < y.hi : x.part < y.part;
+    });
+    stats_.contacts += contacts_.size();
+}
+
+// Bullets that tunnelled are moved back to their earliest impact and get a
+// shallow contact there, the solver then removes the approaching velocity
+void ECSWorld::resolveImpacts() {
+    impacts_.clear();
+    for (const auto& list : threadImpacts_) impacts_.insert(impacts_.end(), list.begin(), list.end());
+    if (impacts_.empty()) return;
+
+    std::sort(impacts_.begin(), impacts_.end(), [&](const Impact& x, const Impact& y) {
+        if (x.t != y.t) return x.t < y.t;
+        flecs::entity_t xb = x.staticB ? staticBodies_[x.bodyB].id : bodies_[x.bodyB].id;
+        flecs::entity_t yb = y.staticB ? staticBodies_[y.bodyB].id : bodies_[y.bodyB].id;
+        return bodies_[x.bodyA].id != bodies_[y.bodyA].id ? bodies_[x.bodyA].id < bodies_[y.bodyA].id : xb < yb;
+    });
+
+    auto rewind = [](PhysicsBody& body, float t) {
+        float back = 1.0f - t;
+        body.transform->x -= body.dx * back;
+        body.transform->y -= body.dy * back;
+        body.t.x = body.transform->x;
+        body.t.y = body.transform->y;
+        computeWorldShape(body.t, body.c, body.shape);
+        body.rewound = true;
+    };
+
+    const size_t discreteCount = contacts_.size();
+    bool anyRewound = false;
+    for (const Impact& imp : impacts_) {
+        PhysicsBody& A = bodies_[imp.bodyA];
+        PhysicsBody& B = imp.staticB ? staticBodies_[imp.bodyB] : bodies_[imp.bodyB];
+        if ((A.bullet && A.rewound) || (B.bullet && B.rewound)) continue; // an earlier impact won
+
+        if (A.bullet) rewind(A, imp.t);
+        if (B.bullet) rewind(B, imp.t);
+        anyRewound = true;
+
+        Contact ct;
+        ct.lo = A.id < B.id ? A.id : B.id;
+        ct.hi = A.id < B.id ? B.id : A.id;
+        ct.part = B.part;
+        ct.bodyA = imp.bodyA;
+        ct.bodyB = imp.bodyB;
+        ct.staticB = imp.staticB;
+        ct.isSensor = false;
+        ct.mtvX = imp.nx * IMPACT_DEPTH;
+        ct.mtvY = imp.ny * IMPACT_DEPTH;
+        contacts_.push_back(ct);
+    }
+    if (!anyRewound) return;
+
+    // discrete contacts of a rewound bullet were found at its end pose: test
+    // them again at the impact pose, drop the ones it no longer touches
+    size_t kept = 0;
+    for (size_t i = 0; i < discreteCount; ++i) {
+        Contact& ct = contacts_[i];
+        const PhysicsBody& A = bodies_[ct.bodyA];
+        const PhysicsBody& B = ct.staticB ? staticBodies_[ct.bodyB] : bodies_[ct.bodyB];
+        if (A.rewound || B.rewound) {
+            Vec2 mtv = {0, 0};
+            ++stats_.satTests;
+            if (!collideBodies(A, B, mtv)) continue;
+            ct.mtvX = mtv.x;
+            ct.mtvY = mtv.y;
+        }
+        contacts_[kept++] = ct;
+    }
+    contacts_.erase(contacts_.begin() + kept, contacts_.begin() + discreteCount);
+}
+
+// Diffs the trigger contacts of this step against the last overlap set
+void ECSWorld::updateTriggers(flecs::world& w) {
+    std::swap(triggerPairs_, prevTriggerPairs_);
+    triggerPairs_.clear();
+
+    for (const Contact& ct : contacts_) {
+        if (!ct.isSensor) continue;
+        if (!triggerPairs_.empty() && triggerPairs_.back().lo == ct.lo && triggerPairs_.back().hi == ct.hi) continue;
+        const PhysicsBody& A = bodies_[ct.bodyA];
+        const PhysicsBody& B = ct.staticB ? staticBodies_[ct.bodyB] : bodies_[ct.bodyB];
+        const bool aTrigger = A.c.isTrigger;
+        triggerPairs_.push_back({ct.lo, ct.hi, aTrigger ? A.id : B.id, aTrigger ? B.id : A.id});
+    }
+
+    // static and sleeping bodies are never tested against each other: a
+    // sleeper inside a static trigger keeps its overlap
+    auto staticSide = [&](flecs::entity_t id) {
+        if (!w.is_alive(id)) return false;
+        flecs::entity e(w, id);
+        return e.has<E_StaticCollider>() || e.has<E_Asleep>();
+    };
+
+    auto less = [](const TriggerPair& x, const TriggerPair& y) {
+        return x.lo != y.lo ? x.lo < y.lo : x.hi < y.hi;
+    };
+
+    const size_t current = triggerPairs_.size();
+    size_t j = 0;
+    for (size_t i = 0; i < current; ++i) {
+        const TriggerPair now = triggerPairs_[i]; // copy, carried pairs are appended below
+        for (; j < prevTriggerPairs_.size() && less(prevTriggerPairs_[j], now); ++j) {
+            const TriggerPair& gone = prevTriggerPairs_[j];
+            if (staticSide(gone.lo) && staticSide(gone.hi)) triggerPairs_.push_back(gone);
+            else triggerEvents_.push_back({flecs::entity(w, gone.trigger), flecs::entity(w, gone.other), false});
+        }
+        if (j < prevTriggerPairs_.size() && !less(now, prevTriggerPairs_[j])) {
+            ++j; // still inside
+            continue;
+        }
+        triggerEvents_.push_back({flecs::entity(w, now.trigger), flecs::entity(w, now.other), true});
+    }
+    for (; j < prevTriggerPairs_.size(); ++j) {
+        const TriggerPair& gone = prevTriggerPairs_[j];
+        if (staticSide(gone.lo) && staticSide(gone.hi)) triggerPairs_.push_back(gone);
+        else triggerEvents_.push_back({flecs::entity(w, gone.trigger), flecs::entity(w, gone.other), false});
+    }
+
+    if (triggerPairs_.size() != current) std::sort(triggerPairs_.begin(), triggerPairs_.end(), less);
+}
+
+size_t ECSWorld::getTriggerOverlaps(flecs::entity trigger, std::vector<flecs::entity_t>& out) const {
+    const size_t first = out.size();
+    for (const TriggerPair& p : triggerPairs_) {
+        if (p.trigger == trigger.id()) out.push_back(p.other);
+        else if (p.other == trigger.id()) out.push_back(p.trigger); // trigger vs trigger
+    }
+    return out.size() - first;
+}
+
+bool ECSWorld::isInTrigger(flecs::entity trigger, flecs::entity other) const {
+    flecs::entity_t lo = std::min(trigger.id(), other.id());
+    flecs::entity_t hi = std::max(trigger.id(), other.id());
+    auto found = std::lower_bound(triggerPairs_.begin(), triggerPairs_.end(), lo,
+        [hi](const TriggerPair& p, flecs::entity_t l) { return p.lo != l ? p.lo < l : p.hi < hi; });
+    return found != triggerPairs_.end() && found->lo == lo && found->hi == hi;
+}
+
+void ECSWorld::resolveContacts(flecs::world& w) {
+    std::swap(manifolds_, prevManifolds_);
+    manifolds_.clear();
+
+    for (size_t i = 0; i < contacts_.size(); ++i) {
+        const Contact& ct = contacts_[i];
+        const PhysicsBody& A = bodies_[ct.bodyA];
+        const PhysicsBody& B = ct.staticB ? staticBodies_[ct.bodyB] : bodies_[ct.bodyB];
+
+        // one event per entity pair, a body on a tile map can touch several of its rects
+        if (i == 0 || contacts_[i - 1].lo != ct.lo || contacts_[i - 1].hi != ct.hi) {
+            collisionEvents_.push_back({flecs::entity(w, A.id), flecs::entity(w, B.id), ct.isSensor});
+        }
+        if (ct.isSensor) continue;
+        if (B.sleeping) wakeList_.push_back(B.id); // solved as static this frame
+
+        float depth = std::sqrt(ct.mtvX * ct.mtvX + ct.mtvY * ct.mtvY);
+        if (depth < 1e-6f) continue;
+
+        // bodies without E_Velocity are only pushed, the impulse ignores them
+        float invMassA = A.velocity ? A.invMass : 0.0f;
+        float invMassB = B.velocity ? B.invMass : 0.0f;
+        if (A.invMass + B.invMass <= 0.0f) continue;
+
+        ContactManifold m;
+        m.lo = ct.lo;
+        m.hi = ct.hi;
+        m.part = ct.part;
+        m.bodyA = ct.bodyA;
+        m.bodyB = ct.bodyB;
+        m.staticB = ct.staticB;
+        m.nx = ct.mtvX / depth;
+        m.ny = ct.mtvY / depth;
+        m.depth = depth;
+        m.mass = invMassA + invMassB > 0.0f ? 1.0f / (invMassA + invMassB) : 0.0f;
+        m.friction = std::sqrt(A.friction * B.friction);
+
+        float e = 0.3f;
+        if (A.hasMaterial && B.hasMaterial) {
+            e = (A.restitution + B.restitution) * 0.5f;
+        }
+        float vn = (B.vx - A.vx) * m.nx + (B.vy - A.vy) * m.ny;
+        m.velocityBias = vn < -RESTITUTION_THRESHOLD ? -e * vn : 0.0f;
+
+        manifolds_.push_back(m);
+    }
+
+    warmStartManifolds();
+    solveManifolds();
+    correctPositions();
+}
+
+PhysicsBody& ECSWorld::manifoldBodyB(const ContactManifold& m) {
+    return m.staticB ? staticBodies_[m.bodyB] : bodies_[m.bodyB];
+}
+
+static bool manifoldLess(const ContactManifold& x, const ContactManifold& y) {
+    if (x.lo != y.lo) return x.lo < y.lo;
+    return x.hi != y.hi ? x.hi < y.hi : x.part < y.part;
+}
+
+// Both lists are sorted by (lo, hi, part): one merge pass finds last frame's impulses
+void ECSWorld::warmStartManifolds() {
+    size_t j = 0;
+    for (ContactManifold& m : manifolds_) {
+        while (j < prevManifolds_.size() && manifoldLess(prevManifolds_[j], m)) {
+            ++j;
+        }
+        if (j == prevManifolds_.size()) break;
+
+        const ContactManifold& old = prevManifolds_[j];
+        if (old.lo != m.lo || old.hi != m.hi || old.part != m.part) continue;
+        if (old.nx * m.nx + old.ny * m.ny < 0.95f) continue; // normal turned, start over
+
+        m.normalImpulse = old.normalImpulse;
+        m.tangentImpulse = old.tangentImpulse;
+
+        PhysicsBody& A = bodies_[m.bodyA];
+        PhysicsBody& B = manifoldBodyB(m);
+        float px = m.nx * m.normalImpulse - m.ny * m.tangentImpulse;
+        float py = m.ny * m.normalImpulse + m.nx * m.tangentImpulse;
+        if (A.velocity) { A.vx -= px * A.invMass; A.vy -= py * A.invMass; }
+        if (B.velocity) { B.vx += px * B.invMass; B.vy += py * B.invMass; }
+    }
+}
+
+// Sequential impulses: accumulated impulses are clamped, not the per-iteration deltas
+void ECSWorld::solveManifolds() {
+    for (int iter = 0; iter < solverIterations_; ++iter) {
+        for (ContactManifold& m : manifolds_) {
+            if (m.mass == 0.0f) continue;
+
+            PhysicsBody& A = bodies_[m.bodyA];
+            PhysicsBody& B = manifoldBodyB(m);
+            const float invA = A.velocity ? A.invMass : 0.0f;
+            const float invB = B.velocity ? B.invMass : 0.0f;
+            const float tx = -m.ny, ty = m.nx;
+
+            // normal
+            float vn = (B.vx - A.vx) * m.nx + (B.vy - A.vy) * m.ny;
+            float dPn = m.mass * (m.velocityBias - vn);
+            float pn = std::fmax(m.normalImpulse + dPn, 0.0f);
+            dPn = pn - m.normalImpulse;
+            m.normalImpulse = pn;
+
+            A.vx -= m.nx * dPn * invA; A.vy -= m.ny * dPn * invA;
+            B.vx += m.nx * dPn * invB; B.vy += m.ny * dPn * invB;
+
+            // friction, bounded by the normal impulse
+            float vt = (B.vx - A.vx) * tx + (B.vy - A.vy) * ty;
+            float maxPt = m.friction * m.normalImpulse;
+            float pt = std::fmin(std::fmax(m.tangentImpulse - m.mass * vt, -maxPt), maxPt);
+            float dPt = pt - m.tangentImpulse;
+            m.tangentImpulse = pt;
+
+            A.vx -= tx * dPt * invA; A.vy -= ty * dPt * invA;
+            B.vx += tx * dPt * invB; B.vy += ty * dPt * invB;
+        }
+    }
+
+    for (const ContactManifold& m : manifolds_) {
+        PhysicsBody& A = bodies_[m.bodyA];
+        PhysicsBody& B = manifoldBodyB(m);
+        if (A.velocity) { A.velocity->vx = A.vx; A.velocity->vy = A.vy; }
+        if (B.velocity) { B.velocity->vx = B.vx; B.velocity->vy = B.vy; }
+    }
+}
+
+// Pushes out a part of the penetration so resting contacts don't fight the solver
+void ECSWorld::correctPositions() {
+    for (const ContactManifold& m : manifolds_) {
+        PhysicsBody& A = bodies_[m.bodyA];
+        PhysicsBody& B = manifoldBodyB(m);
+
+        float totalInvMass = A.invMass + B.invMass;
+        float c = std::fmax(m.depth - POSITION_SLOP, 0.0f) * POSITION_CORRECTION / totalInvMass;
+        if (c == 0.0f) continue;
+
+        if (A.transform) {
+            A.transform->x -= m.nx * c * A.invMass;
+            A.transform->y -= m.ny * c * A.invMass;
+        }
+        if (B.transform) {
+            B.transform->x += m.nx * c * B.invMass;
+            B.transform->y += m.ny * c * B.invMass;
+        }
+    }
+}
+
+void ECSWorld::setSolverIterations(int iterations) {
+    solverIterations_ = iterations > 0 ? iterations : 1;
+}
+
+// ================= Sleeping =================
+
+static uint32_t findIsland(std::vector<uint32_t>& parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void ECSWorld::updateSleep(flecs::world& w, float dt) {
+    // touched sleepers are dynamic again from the next frame
+    for (flecs::entity_t id : wakeList_) wake(flecs::entity(w, id));
+    wakeList_.clear();
+    if (!sleepEnabled_) return;
+
+    // islands = connected components of the contact graph. Static bodies
+    // don't join them, or the whole level would be one island
+    const uint32_t count = (uint32_t)bodies_.size();
+    islandParent_.resize(count);
+    for (uint32_t i = 0; i < count; ++i) islandParent_[i] = i;
+    for (const ContactManifold& m : manifolds_) {
+        bodies_[m.bodyA].touching = true;
+        if (m.staticB) continue;
+        bodies_[m.bodyB].touching = true;
+        uint32_t ra = findIsland(islandParent_, m.bodyA);
+        uint32_t rb = findIsland(islandParent_, m.bodyB);
+        if (ra != rb) islandParent_[ra] = rb;
+    }
+
+    // an island sleeps when its most restless body was idle long enough.
+    // Slow free bodies keep drifting: without a contact only a stopped body is idle
+    islandIdle_.assign(count, FLT_MAX);
+    for (uint32_t i = 0; i < count; ++i) {
+        PhysicsBody& b = bodies_[i];
+        float idle = -1.0f; // bodies without E_Velocity keep their island awake
+        if (b.sleep && b.sleep->canSleep && b.velocity) {
+            bool slow = b.vx * b.vx + b.vy * b.vy < SLEEP_VELOCITY * SLEEP_VELOCITY;
+            slow = slow && (b.touching || (b.vx == 0.0f && b.vy == 0.0f));
+            b.sleep->idleTime = slow ? b.sleep->idleTime + dt : 0.0f;
+            idle = b.sleep->idleTime;
+        }
+        uint32_t root = findIsland(islandParent_, i);
+        islandIdle_[root] = std::fmin(islandIdle_[root], idle);
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (islandIdle_[findIsland(islandParent_, i)] >= TIME_TO_SLEEP) putToSleep(w, bodies_[i]);
+    }
+}
+
+// Moves the body to the static side: out of qDynamic_ and the systems, tested
+// only when an awake body queries the static tree
+void ECSWorld::putToSleep(flecs::world& w, const PhysicsBody& body) {
+    uint32_t slot = staticSlot(body.id);
+    PhysicsBody& s = staticBodies_[slot];
+    s = body;
+    s.t = *body.transform; // resolve may have pushed it since the snapshot
+    s.transform = nullptr;
+    s.velocity = nullptr;
+    s.sleep = nullptr;
+    s.invMass = 0.0f;
+    s.vx = s.vy = 0.0f;
+    s.gridLevel = 0;
+    s.bullet = false;
+    s.dx = s.dy = 0.0f;
+    s.sleeping = true;
+    computeWorldShape(s.t, s.c, s.shape);
+
+    float r = s.shape.radius;
+    s.box = {s.shape.cx - r, s.shape.cy - r, s.shape.cx + r, s.shape.cy + r};
+    staticTree_.update(body.id, s.box, slot);
+
+    if (body.velocity) {
+        body.velocity->vx = 0.0f;
+        body.velocity->vy = 0.0f;
+    }
+    flecs::entity(w, body.id).add<E_Asleep>();
+}
+
+void ECSWorld::wake(flecs::entity e) {
+    if (!e.has<E_Asleep>()) return;
+    removeStaticBody(e.id());
+    e.remove<E_Asleep>();
+    if (E_Sleep* s = e.try_get_mut<E_Sleep>()) s->idleTime = 0.0f;
+}
+
+// get_mut writes fire no OnSet: a sleeper whose velocity is no longer zero
+// (putToSleep zeroed it) or whose transform left the sleeping pose was changed
+// by game code since the last update()
+void ECSWorld::wakeChangedSleepers() {
+    qAsleep_.each([&](flecs::entity e, const E_Transform& t, const E_Velocity* v) {
+        bool moved = v && (v->vx != 0.0f || v->vy != 0.0f);
+        auto found = staticSlots_.find(e.id());
+        if (!moved && found != staticSlots_.end()) {
+            const E_Transform& pose = staticBodies_[found->second].t;
+            moved = t.x != pose.x || t.y != pose.y || t.angle != pose.angle;
+        }
+        if (moved) wakeList_.push_back(e.id());
+    });
+    for (flecs::entity_t id : wakeList_) wake(flecs::entity(world, id));
+    wakeList_.clear();
+}
+
+void ECSWorld::setSleepEnabled(bool enabled) {
+    sleepEnabled_ = enabled;
+    if (enabled) return;
+
+    std::vector<flecs::entity> sleepers;
+    qAsleep_.each([&](flecs::entity e, const E_Transform&, const E_Velocity*) { sleepers.push_back(e); });
+    for (flecs::entity e : sleepers) wake(e);
+}
+
+void ECSWorld::dispatchCollisionCallbacks(size_t firstEvent) {
+    if (collisionCallbacks_.empty()) return;
+
+    for (size_t i = firstEvent; i < collisionEvents_.size(); ++i) {
+        const E_CollisionEvent& ev = collisionEvents_[i];
+        auto itA = collisionCallbacks_.find(ev.a.id());
+        if (itA != collisionCallbacks_.end()) itA->second(ev);
+
+        auto itB = collisionCallbacks_.find(ev.b.id());
+        if (itB != collisionCallbacks_.end()) itB->second({ev.b, ev.a, ev.isTrigger});
+    }
+}
+
+void ECSWorld::onCollision(flecs::entity e, CollisionCallback callback) {
+    collisionCallbacks_[e.id()] = std::move(callback);
+}
+
+void ECSWorld::removeCollisionCallback(flecs::entity e) {
+    collisionCallbacks_.erase(e.id());
+}
+
+// ================= Scene queries =================
+// Queries read the colliders of the last physics step (bodies_, the broadphase
+// and the static tree) and never write, so they may run on worker threads
+
+static bool acceptsQuery(const PhysicsBody& b, const QueryFilter& filter) {
+    if (!b.c.active) return false;
+    if (b.c.isTrigger && !filter.includeTriggers) return false;
+    if (b.id == filter.ignore) return false;
+    return (filter.layers & layerBit(b.c.layer)) != 0;
+}
+
+// Calls f(body, maxT) -> new maxT for bodies whose box the segment p + d * t,
+// t in [0, maxT] crosses. The grid is walked cell by cell (DDA) and stops once
+// the ray leaves maxT behind. A body may be visited more than once
+template<typename F>
+void ECSWorld::walkRay(float px, float py, float dx, float dy, uint32_t layers, F&& f) const {
+    float maxT = staticTree_.raycast(px, py, dx, dy, 1.0f, [&](uint32_t slot, float t) {
+        return f(staticBodies_[slot], t);
+    });
+
+    const uint32_t queryLayers = layers & activeLayers_;
+    auto visit = [&](uint32_t i) {
+        if (bodies_[i].box.intersectsSegment(px, py, dx, dy, maxT)) maxT = f(bodies_[i], maxT);
+    };
+
+    switch (broadphaseMode_) {
+        case BroadphaseMode::SweepAndPrune: {
+            // intervals overlapping the bounding box of the segment, up to the static hit
+            const float ex = px + dx * maxT, ey = py + dy * maxT;
+            const Aabb bounds = {std::fmin(px, ex), std::fmin(py, ey), std::fmax(px, ex), std::fmax(py, ey)};
+            sap_.query(bounds, [&](uint32_t i) {
+                if (queryLayers & layerBit(bodies_[i].c.layer)) visit(i);
+            });
+            return;
+        }
+        case BroadphaseMode::AabbTree:
+            for (uint32_t l = queryLayers; l; l &= l - 1) {
+                maxT = trees_[__builtin_ctz(l)].raycast(px, py, dx, dy, maxT, [&](uint32_t i, float t) {
+                    return f(bodies_[i], t);
+                });
+            }
+            return;
+        case BroadphaseMode::Grid:
+            break;
+    }
+
+    if (queryLayers == 0) return;
+
+    // only the part of the ray over the moving bodies can hit one, a long ray
+    // would walk thousands of empty cells on the small levels otherwise
+    float tEnter, tExit;
+    const Aabb bounds = {dynamicBounds_.minX - 1.0f, dynamicBounds_.minY - 1.0f,
+                         dynamicBounds_.maxX + 1.0f, dynamicBounds_.maxY + 1.0f};
+    if (!bounds.clipSegment(px, py, dx, dy, maxT, tEnter, tExit)) return;
+
+    // one DDA per occupied level, maxT carries over from the levels before.
+    // t stays measured along the whole ray
+    for (int level = 0; level < MAX_GRID_LEVELS; ++level) {
+        const uint32_t levelLayers = queryLayers & levelLayers_[level];
+        if (levelLayers == 0) continue;
+        if (tEnter > maxT) return;
+
+        const float cs = cellSize(level);
+        const float tEnd = std::fmin(tExit, maxT);
+        int cx = (int)floorf((px + dx * tEnter) / cs);
+        int cy = (int)floorf((py + dy * tEnter) / cs);
+        const int endX = (int)floorf((px + dx * tEnd) / cs);
+        const int endY = (int)floorf((py + dy * tEnd) / cs);
+        const int stepX = dx > 0.0f ? 1 : -1;
+        const int stepY = dy > 0.0f ? 1 : -1;
+
+        // t at the next vertical / horizontal cell border, and t per cell
+        const float tDeltaX = dx != 0.0f ? cs / std::fabs(dx) : FLT_MAX;
+        const float tDeltaY = dy != 0.0f ? cs / std::fabs(dy) : FLT_MAX;
+        float tMaxX = dx != 0.0f ? ((cx + (dx > 0.0f ? 1 : 0)) * cs - px) / dx : FLT_MAX;
+        float tMaxY = dy != 0.0f ? ((cy + (dy > 0.0f ? 1 : 0)) * cs - py) / dy : FLT_MAX;
+
+        int cellsLeft = std::abs(endX - cx) + std::abs(endY - cy) + 1;
+        while (cellsLeft-- > 0) {
+            for (uint32_t l = levelLayers; l; l &= l - 1) {
+                for (uint32_t i : grid_.cell(hashCellGlobal(cx, cy, __builtin_ctz(l), level))) visit(i);
+            }
+
+            // every hit inside this cell is known now
+            float tExit = tMaxX < tMaxY ? tMaxX : tMaxY;
+            if (tExit >= maxT) break;
+
+            if (tMaxX < tMaxY) { cx += stepX; tMaxX += tDeltaX; }
+            else               { cy += stepY; tMaxY += tDeltaY; }
+        }
+    }
+}
+
+// Calls f(body) once for every body whose box overlaps the box
+template<typename F>
+void ECSWorld::walkBox(const Aabb& box, uint32_t layers, F&& f) const {
+    staticTree_.query(box, [&](uint32_t slot) {
+        if (staticBodies_[slot].box.overlaps(box)) f(staticBodies_[slot]);
+    });
+
+    const uint32_t queryLayers = layers & activeLayers_;
+
+    switch (broadphaseMode_) {
+        case BroadphaseMode::SweepAndPrune:
+            sap_.query(box, [&](uint32_t i) {
+                if (queryLayers & layerBit(bodies_[i].c.layer)) f(bodies_[i]);
+            });
+            return;
+        case BroadphaseMode::AabbTree:
+            for (uint32_t l = queryLayers; l; l &= l - 1) {
+                trees_[__builtin_ctz(l)].query(box, [&](uint32_t i) {
+                    if (bodies_[i].box.overlaps(box)) f(bodies_[i]);
+                });
+            }
+            return;
+        case BroadphaseMode::Grid:
+            break;
+    }
+
+    // cells outside the moving bodies are empty. Clipping the box keeps the
+    // ownership below: every body box is inside the bounds
+    if (queryLayers == 0 || !box.overlaps(dynamicBounds_)) return;
+    const Aabb clipped = {std::fmax(box.minX, dynamicBounds_.minX), std::fmax(box.minY, dynamicBounds_.minY),
+                          std::fmin(box.maxX, dynamicBounds_.maxX), std::fmin(box.maxY, dynamicBounds_.maxY)};
+
+    for (int level = 0; level < MAX_GRID_LEVELS; ++level) {
+        const uint32_t levelLayers = queryLayers & levelLayers_[level];
+        if (levelLayers == 0) continue;
+
+        const float cs = cellSize(level);
+        const int cMinX = (int)floorf(clipped.minX / cs), cMaxX = (int)floorf(clipped.maxX / cs);
+        const int cMinY = (int)floorf(clipped.minY / cs), cMaxY = (int)floorf(clipped.maxY / cs);
+
+        for (uint32_t l = levelLayers; l; l &= l - 1) {
+            const int layer = __builtin_ctz(l);
+            for (int x = cMinX; x <= cMaxX; ++x)
+            for (int y = cMinY; y <= cMaxY; ++y) {
+                for (uint32_t i : grid_.cell(hashCellGlobal(x, y, layer, level))) {
+                    const Aabb& b = bodies_[i].box;
+                    if (!b.overlaps(clipped)) continue;
+                    // same ownership rule as the pair search: report from one cell only
+                    float ox = b.minX > clipped.minX ? b.minX : clipped.minX;
+                    float oy = b.minY > clipped.minY ? b.minY : clipped.minY;
+                    if ((int)floorf(ox / cs) != x || (int)floorf(oy / cs) != y) continue;
+                    f(bodies_[i]);
+                }
+            }
+        }
+    }
+}
+
+bool ECSWorld::raycast(float x0, float y0, float x1, float y1, RayHit& hit, const QueryFilter& filter) const {
+    const float dx = x1 - x0, dy = y1 - y0;
+    hit = RayHit{};
+
+    walkRay(x0, y0, dx, dy, filter.layers, [&](const PhysicsBody& b, float maxT) {
+        float t;
+        Vec2 n;
+        if (!acceptsQuery(b, filter)) return maxT;
+        if (!raycastShape(b.shape, {x0, y0}, {dx, dy}, t, n) || t >= maxT) return maxT;
+        hit = {b.id, x0 + dx * t, y0 + dy * t, n.x, n.y, t};
+        return t;
+    });
+    return hit.entity != 0;
+}
+
+size_t ECSWorld::raycastAll(float x0, float y0, float x1, float y1, std::vector<RayHit>& hits,
+                            const QueryFilter& filter) const {
+    const float dx = x1 - x0, dy = y1 - y0;
+    const size_t first = hits.size();
+
+    walkRay(x0, y0, dx, dy, filter.layers, [&](const PhysicsBody& b, float maxT) {
+        float t;
+        Vec2 n;
+        if (acceptsQuery(b, filter) && raycastShape(b.shape, {x0, y0}, {dx, dy}, t, n)) {
+            hits.push_back({b.id, x0 + dx * t, y0 + dy * t, n.x, n.y, t});
+        }
+        return maxT;
+    });
+
+    // bodies spanning several cells are found more than once
+    auto begin = hits.begin() + first;
+    std::sort(begin, hits.end(), [](const RayHit& a, const RayHit& b) {
+        return a.entity != b.entity ? a.entity < b.entity : a.fraction < b.fraction;
+    });
+    hits.erase(std::unique(begin, hits.end(), [](const RayHit& a, const RayHit& b) {
+        return a.entity == b.entity;
+    }), hits.end());
+    std::sort(hits.begin() + first, hits.end(), [](const RayHit& a, const RayHit& b) {
+        return a.fraction < b.fraction;
+    });
+    return hits.size() - first;
+}
+
+void ECSWorld::raycastBatch(const Ray* rays, size_t count, RayHit* hits, const QueryFilter& filter) {
+    jobs_.parallelFor((uint32_t)count, 64, [&](uint32_t begin, uint32_t end, unsigned) {
+        for (uint32_t i = begin; i < end; ++i) {
+            const Ray& r = rays[i];
+            raycast(r.x, r.y, r.x + r.dx, r.y + r.dy, hits[i], filter);
+        }
+    });
+}
+
+size_t ECSWorld::overlapShape(const WorldShape& shape, std::vector<flecs::entity_t>& out,
+                              const QueryFilter& filter) const {
+    const size_t first = out.size();
+    const Aabb box = {shape.cx - shape.radius, shape.cy - shape.radius,
+                      shape.cx + shape.radius, shape.cy + shape.radius};
+
+    walkBox(box, filter.layers, [&](const PhysicsBody& b) {
+        if (acceptsQuery(b, filter) && shapesOverlap(shape, b.shape)) out.push_back(b.id);
+    });
+    return out.size() - first;
+}
+
+size_t ECSWorld::overlapCircle(float x, float y, float radius, std::vector<flecs::entity_t>& out,
+                               const QueryFilter& filter) const {
+    WorldShape shape;
+    shape.cx = shape.mx = x;
+    shape.cy = shape.my = y;
+    shape.radius = radius;
+    return overlapShape(shape, out, filter);
+}
+
+size_t ECSWorld::overlapRect(float x, float y, float width, float height, float angle,
+                             std::vector<flecs::entity_t>& out, const QueryFilter& filter) const {
+    E_Transform t {};
+    t.x = x;
+    t.y = y;
+    t.angle = angle;
+    E_Collider c;
+    c.type = ColliderType::Rect;
+    c.width = width;
+    c.height = height;
+
+    WorldShape shape;
+    computeWorldShape(t, c, shape);
+    return overlapShape(shape, out, filter);
+}
+
+bool ECSWorld::shapeCast(const E_Collider& collider, float x, float y, float angle, float dx, float dy,
+                         RayHit& hit, const QueryFilter& filter) const {
+    // the cast shape at the end of the motion, like a bullet in the narrowphase
+    E_Transform t {};
+    t.x = x + dx;
+    t.y = y + dy;
+    t.angle = angle;
+    WorldShape shape;
+    computeWorldShape(t, collider, shape);
+
+    const float r = shape.radius;
+    Aabb box = {shape.cx - r - std::fmax(0.0f, dx), shape.cy - r - std::fmax(0.0f, dy),
+                shape.cx + r - std::fmin(0.0f, dx), shape.cy + r - std::fmin(0.0f, dy)};
+
+    hit = RayHit{};
+    walkBox(box, filter.layers, [&](const PhysicsBody& b) {
+        float toi;
+        Vec2 n;
+        if (!acceptsQuery(b, filter)) return;
+        if (!timeOfImpact(b.shape, shape, {dx, dy}, toi, n) || toi >= hit.fraction) return;
+        // n goes from the body to the cast shape: the body's surface normal
+        hit = {b.id, x + dx * toi, y + dy * toi, n.x, n.y, toi};
+    });
+    return hit.entity != 0;
+}
+
+// ================= Fixed step =================
+
+void ECSWorld::integrate(float dt, uint32_t count) {
+    bodyStore_.resize(count);
+    if (count == 0) return;
+    integrateTables_.push_back({nullptr, nullptr, nullptr, count}); // end marker
+
+    jobs_.parallelFor(count, 4096, [&](uint32_t begin, uint32_t end, unsigned) {
+        BodyStore& s = bodyStore_;
+        auto table = std::upper_bound(integrateTables_.begin(), integrateTables_.end(), begin,
+            [](uint32_t i, const IntegrateTable& t) { return i < t.first; }) - 1;
+
+        // E_Transform/E_Velocity/E_Gravity -> columns
+        for (auto tab = table; tab->first < end; ++tab) {
+            uint32_t lo = std::max(begin, tab->first), hi = std::min(end, (tab + 1)->first);
+            for (uint32_t i = lo; i < hi; ++i) {
+                const E_Transform& t = tab->transforms[i - tab->first];
+                const E_Velocity& v = tab->velocities[i - tab->first];
+                const E_Gravity* g = tab->gravity ? &tab->gravity[i - tab->first] : nullptr;
+                s.x[i] = t.x;
+                s.y[i] = t.y;
+                s.vx[i] = v.vx;
+                s.vy[i] = v.vy;
+                s.moveScale[i] = v.freeze ? 0.0f : 1.0f;
+                s.gravity[i] = g && g->work && !v.freeze ? g->a : 0.0f;
+            }
+        }
+
+        integrateBodies(s, dt, begin, end);
+
+        // columns -> components
+        for (auto tab = table; tab->first < end; ++tab) {
+            uint32_t lo = std::max(begin, tab->first), hi = std::min(end, (tab + 1)->first);
+            for (uint32_t i = lo; i < hi; ++i) {
+                E_Transform& t = tab->transforms[i - tab->first];
+                E_Velocity& v = tab->velocities[i - tab->first];
+                t.x = s.x[i];
+                t.y = s.y[i];
+                v.vy = s.vy[i];
+            }
+        }
+    });
+}
+
 void ECSWorld::update(float dt) {
+    collisionEvents_.clear();
+    triggerEvents_.clear();
+
+    // the last step's body and grid values stay, the sums restart
+    PhysicsStats last = stats_;
+    stats_ = PhysicsStats{};
+    stats_.bodies = last.bodies;
+    stats_.staticBodies = last.staticBodies;
+    stats_.occupiedCells = last.occupiedCells;
+    std::copy(std::begin(last.cellsPerLevel), std::end(last.cellsPerLevel), stats_.cellsPerLevel);
+    stats_.gridEntries = last.gridEntries;
+    stats_.maxPerCell = last.maxPerCell;
+    stats_.avgPerCell = last.avgPerCell;
+    for (WorkerCounters& counters : threadCounters_) counters = WorkerCounters{};
+
+    if (sleepEnabled_) wakeChangedSleepers();
+
+    accumulator_ += dt;
+    int steps = 0;
+    while (accumulator_ >= fixedDt_ && steps < maxSubsteps_) {
+        storePrevTransforms();
+        StatsClock::time_point lap = StatsClock::now();
+        integrateSystem_.run(fixedDt_);
+        stats_.integrateMs += lapMs(lap);
+        collisionSystem_.run(fixedDt_);
+        accumulator_ -= fixedDt_;
+        ++steps;
+    }
+    // out of substeps: drop the backlog instead of spiralling
+    if (accumulator_ >= fixedDt_) accumulator_ = std::fmod(accumulator_, fixedDt_);
+
+    stats_.steps = steps;
+    for (const WorkerCounters& counters : threadCounters_) {
+        stats_.cellPairs += counters.cellPairs;
+        stats_.aabbRejects += counters.aabbRejects;
+        stats_.duplicatePairs += counters.duplicatePairs;
+        stats_.candidatePairs += counters.candidatePairs;
+        stats_.satTests += counters.satTests;
+        stats_.batchedTests += counters.batchedTests;
+    }
+
     world.progress(dt);
 }
 
+void ECSWorld::storePrevTransforms() {
+    world.defer_begin();
+    qPrevTransform_.each([](flecs::entity e, const E_Transform& t, E_PrevTransform* prev) {
+        if (prev) *prev = {t.x, t.y, t.angle};
+        else e.set<E_PrevTransform>({t.x, t.y, t.angle});
+    });
+    world.defer_end();
+}
+
+void ECSWorld::setPhysicsRate(float hz, int maxSubsteps) {
+    if (hz > 0.0f) fixedDt_ = 1.0f / hz;
+    maxSubsteps_ = maxSubsteps > 0 ? maxSubsteps : 1;
+}
+
 void ECSWorld::drawSprite(E_Sprite sprite, bool isLineLoop) {
     GLenum mode = isLineLoop ? GL_LINE_LOOP : (sprite.type == E_Sprite::RECTANGLE ? GL_QUADS : GL_TRIANGLE_FAN);
 
@@ -478,37 +1876,100 @@ void ECSWorld::drawSprite(E_Sprite sprite, bool isLineLoop) {
     glEnd();
 }
 
-bool ECSWorld::hoverIt(E_Sprite &s, flecs::entity &e, E_Transform &t)
-{
-    // 1. Check if entity is valid
-    if (!e.is_alive()) return false;
+// ================= Mouse picking =================
+
+// Box of the sprite around its transform (rotation and scale are ignored)
+static bool spriteBounds(const E_Sprite& s, const E_Transform& t, Aabb& box) {
+    float hw, hh;
+    switch (s.type) {
+        case E_Sprite::RECTANGLE:
+        case E_Sprite::TRIANGLE:
+            hw = s.width / 2.0f;
+            hh = s.height / 2.0f;
+            break;
+        case E_Sprite::CIRCLE:
+            hw = hh = s.radius;
+            break;
+        default:
+            return false;
+    }
+    box = {t.x - hw, t.y - hh, t.x + hw, t.y + hh};
+    return true;
+}
+
+uint32_t ECSWorld::pickSlot(flecs::entity_t id) {
+    auto it = pickSlots_.find(id);
+    if (it != pickSlots_.end()) return it->second;
+
+    uint32_t slot;
+    if (!freePickSlots_.empty()) {
+        slot = freePickSlots_.back();
+        freePickSlots_.pop_back();
+    } else {
+        slot = (uint32_t)pickEntities_.size();
+        pickEntities_.emplace_back();
+        pickBoxes_.emplace_back();
+    }
+    pickEntities_[slot] = id;
+    pickSlots_[id] = slot;
+    return slot;
+}
 
-    // 2. Get World and Check Input Presence
-    const flecs::world& w = e.world();
-    if (!w.has<E_InputState>()) return false;
+void ECSWorld::syncPickable(flecs::entity e, const E_Transform& t, const E_Sprite& s) {
+    Aabb box;
+    if (!spriteBounds(s, t, box)) {
+        removePickable(e.id());
+        return;
+    }
+    uint32_t slot = pickSlot(e.id());
+    pickBoxes_[slot] = box;
+    pickTree_.update(e.id(), box, slot);
+}
 
-    // 3. Safe Input Access (Take address of reference)
-    const E_InputState* input = &w.get<E_InputState>();
+void ECSWorld::removePickable(flecs::entity_t id) {
+    auto it = pickSlots_.find(id);
+    if (it == pickSlots_.end()) return;
+    pickTree_.remove(id);
+    freePickSlots_.push_back(it->second);
+    pickSlots_.erase(it);
+}
 
-    float mx = (float)input->mouseX;
-    float my = (float)input->mouseY;
+void ECSWorld::screenToWorld(float sx, float sy, float& wx, float& wy) const {
+    wx = sx * screenToWorld_.scale + screenToWorld_.offsetX;
+    wy = sy * screenToWorld_.scale + screenToWorld_.offsetY;
+}
 
-    // 4. Safe Window Size Access
+void ECSWorld::worldToScreen(float wx, float wy, float& sx, float& sy) const {
+    sx = (wx - screenToWorld_.offsetX) / screenToWorld_.scale;
+    sy = (wy - screenToWorld_.offsetY) / screenToWorld_.scale;
+}
+
+size_t ECSWorld::pickAt(float x, float y, std::vector<flecs::entity_t>& out) const {
+    const size_t first = out.size();
+    const Aabb point = {x, y, x, y};
+    pickTree_.query(point, [&](uint32_t slot) {
+        if (pickBoxes_[slot].overlaps(point)) out.push_back(pickEntities_[slot]);
+    });
+    return out.size() - first;
+}
+
+void ECSWorld::updatePicking(flecs::world w) {
+    if (!w.has<E_InputState>()) return;
+    const E_InputState& input = w.get<E_InputState>();
+
+    // camera -> cached screen-to-world transform
     float winW = 800.0f;
     float winH = 600.0f;
-    
     if (w.has<E_WindowSize>()) {
-        const E_WindowSize* ws = &w.get<E_WindowSize>(); // Address of reference
-        winW = (float)ws->w;
-        winH = (float)ws->h;
+        const E_WindowSize& ws = w.get<E_WindowSize>();
+        winW = (float)ws.w;
+        winH = (float)ws.h;
     }
 
-    // 5. Camera Logic
-    float camX = winW * 0.5f; 
+    float camX = winW * 0.5f;
     float camY = winH * 0.5f;
     float zoom = 1.0f;
-
-    qCamera_.each([&](flecs::entity eCam, E_Transform& ct, E_Camera& cc) {
+    qCamera_.each([&](flecs::entity, E_Transform& ct, E_Camera& cc) {
         if (cc.active) {
             camX = ct.x;
             camY = ct.y;
@@ -516,63 +1977,51 @@ bool ECSWorld::hoverIt(E_Sprite &s, flecs::entity &e, E_Transform &t)
         }
     });
 
-    // 6. Coordinates Calculation
-    float screenCenteredX = mx - winW * 0.5f;
-    float screenCenteredY = my - winH * 0.5f;
-
-    float unzoomedX = screenCenteredX / zoom;
-    float unzoomedY = screenCenteredY / zoom;
-
-    float worldMX = unzoomedX + camX;
-    float worldMY = unzoomedY + camY;
+    // world = (screen - window / 2) / zoom + camera
+    screenToWorld_.scale = 1.0f / zoom;
+    screenToWorld_.offsetX = camX - winW * 0.5f / zoom;
+    screenToWorld_.offsetY = camY - winH * 0.5f / zoom;
+    screenToWorld((float)input.mouseX, (float)input.mouseY, mouseWorldX_, mouseWorldY_);
 
-    // 7. AABB Logic
-    float left, right, top, bottom;
+    qPickMoving_.each([this](flecs::entity e, const E_Transform& t, const E_Sprite& s) {
+        syncPickable(e, t, s);
+    });
 
-    switch(s.type) {
-        case E_Sprite::RECTANGLE: {
-            float hw = s.width / 2.0f;
-            float hh = s.height / 2.0f;
-            left = t.x - hw;
-            right = t.x + hw;
-            top = t.y - hh;
-            bottom = t.y + hh;
-            break;
+    prevHovered_.swap(hovered_);
+    hovered_.clear();
+    pickAt(mouseWorldX_, mouseWorldY_, hovered_);
+    std::sort(hovered_.begin(), hovered_.end());
+
+    auto setHover = [&](flecs::entity e, bool hover) {
+        if (E_EffectHover* effect = e.try_get_mut<E_EffectHover>()) {
+            E_Transform* t = e.try_get_mut<E_Transform>();
+            if (effect->work && t) {
+                t->xScale = hover ? effect->offsetX : 1.0f;
+                t->yScale = hover ? effect->offsetY : 1.0f;
+            }
         }
-        case E_Sprite::CIRCLE: {
-            left = t.x - s.radius;
-            right = t.x + s.radius;
-            top = t.y - s.radius;
-            bottom = t.y + s.radius;
-            break;
+        if (E_Clickable* btn = e.try_get_mut<E_Clickable>()) {
+            btn->isHovered = hover;
+            btn->isClicked = hover && input.leftPressed;
+            if (btn->isClicked && btn->onClick) btn->onClick();
         }
-        case E_Sprite::TRIANGLE: {
-            float hw = s.width / 2.0f;
-            float hh = s.height / 2.0f;
-            left = t.x - hw;
-            right = t.x + hw;
-            top = t.y - hh;
-            bottom = t.y + hh;
-            break;
-        }
-        default: return false;
-    }
-
-    bool isInside = (worldMX >= left && worldMX <= right && worldMY >= top && worldMY <= bottom);
+    };
 
-    // 8. Safe Effect Access
-    if (e.has<E_EffectHover>()) {
-        const E_EffectHover* Chover = &e.get<E_EffectHover>(); // Address of reference
-        if (Chover->work) {
-             if (isInside) {
-                t.xScale = Chover->offsetX; 
-                t.yScale = Chover->offsetY;
-            } else {
-                t.xScale = 1.0f; 
-                t.yScale = 1.0f;
-            }
-        }
+    // the cursor left these
+    for (flecs::entity_t id : prevHovered_) {
+        if (std::binary_search(hovered_.begin(), hovered_.end(), id)) continue;
+        if (w.is_alive(id)) setHover(w.entity(id), false);
     }
+    for (flecs::entity_t id : hovered_) {
+        setHover(w.entity(id), true);
+    }
+}
+
+bool ECSWorld::hoverIt(E_Sprite &s, flecs::entity &e, E_Transform &t)
+{
+    if (!e.is_alive()) return false;
 
-    return isInside;
+    Aabb box;
+    if (!spriteBounds(s, t, box)) return false;
+    return box.overlaps({mouseWorldX_, mouseWorldY_, mouseWorldX_, mouseWorldY_});
 }
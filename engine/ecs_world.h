@@ -4,62 +4,313 @@
 
 #pragma once
 
+#include <memory>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 #include <functional>
 #include <flecs.h>
 #include "components.h" 
-
-// Hashing helper for spatial grid
-static inline uint64_t hashCellGlobal(int x, int y) { 
-    return (uint64_t((uint32_t)x) << 32) | (uint32_t)y; 
-}
+#include "broadphase.h"
+#include "collision.h"
+#include "job_system.h"
 
 class ECSWorld {
 public:
     ECSWorld();
+    ~ECSWorld();
     
-    // Initializes the world, registers components and systems
-    void init();
+    // Initializes the world, registers components and systems. Headless: the
+    // systems that draw (CameraSystem, RenderSystem) are disabled
+    void init(bool headless = false);
+    bool isHeadless() const { return headless_; }
     
-    // Updates the ECS world (ticks systems)
+    // Updates the ECS world (ticks systems). Physics (IntegrateSystem, CollisionSystem)
+    // runs 0..maxSubsteps fixed steps of the accumulated time
     void update(float dt);
+
+    // Physics step rate (60 Hz by default) and the cap of steps per update()
+    void setPhysicsRate(float hz, int maxSubsteps = 5);
+    float getFixedDeltaTime() const { return fixedDt_; }
+    // Part of a fixed step left in the accumulator, [0, 1), used by RenderSystem
+    float getInterpolationAlpha() const { return accumulator_ / fixedDt_; }
     
     flecs::world& getWorld() { return world; }
 
     // Render helpers
     void drawSprite(E_Sprite sprite, bool isLineLoop = false);
     
-    // Helper to check if mouse is hovering over an entity
-    // TODO: Needs to account for Camera position/zoom in future
+    // Mouse picking. ClickableSystem maps the mouse to the world once per frame
+    // (camera position and zoom) and looks it up in a tree of the sprites with
+    // E_Clickable/E_EffectHover. Call set<E_Transform>/set<E_Sprite> after moving
+    // or resizing one through get_mut, bodies with E_Velocity are followed.
+    // hoverIt: is the mouse (as of the last frame) inside the sprite
     bool hoverIt(E_Sprite &s, flecs::entity &e, E_Transform &t);
+    void screenToWorld(float sx, float sy, float& wx, float& wy) const;
+    void worldToScreen(float wx, float wy, float& sx, float& sy) const;
+    void getMouseWorld(float& x, float& y) const { x = mouseWorldX_; y = mouseWorldY_; }
+    // appends the pickable sprites whose box holds the world point
+    size_t pickAt(float x, float y, std::vector<flecs::entity_t>& out) const;
+    // pickable sprites under the mouse this frame, sorted by id
+    Span<flecs::entity_t> hoveredEntities() const { return {hovered_.data(), hovered_.size()}; }
+
+    // Collision layers. E_Collider::layer is an index in [0, 32) and E_Collider::mask
+    // the layers it accepts. A pair collides if the layer matrix allows it and each
+    // mask has the other's layer. Layers are separate broadphase partitions:
+    // layers that don't collide never produce candidate pairs.
+    // By default a layer collides only with itself
+    void setLayerCollision(int layerA, int layerB, bool collide);
+    bool getLayerCollision(int layerA, int layerB) const {
+        return layerMatrix_[layerA & (MAX_LAYERS - 1)] & layerBit(layerB);
+    }
+    bool canCollide(const E_Collider& a, const E_Collider& b) const {
+        return (layerMatrix_[a.layer & (MAX_LAYERS - 1)] & layerBit(b.layer))
+            && (a.mask & layerBit(b.layer)) && (b.mask & layerBit(a.layer));
+    }
+
+    // Broadphase used by the collision systems (Grid by default)
+    void setBroadphaseMode(BroadphaseMode mode);
+    BroadphaseMode getBroadphaseMode() const { return broadphaseMode_; }
+
+    // Counters and phase times of the physics steps of the last update(),
+    // for tuning CELL_SIZE, layers and thread counts
+    const PhysicsStats& getPhysicsStats() const { return stats_; }
+    // Appends the occupied cells of the last step (grid mode), returns their count
+    size_t getGridCells(std::vector<GridCellStat>& out) const;
+
+    // Static colliders (E_Collider::isStatic) are kept in a persistent tree that is
+    // updated on set<E_Transform>/set<E_Collider> and on removal. Call this after
+    // moving a static collider through get_mut
+    void moveStaticCollider(flecs::entity e);
+
+    // Changes one tile of an E_TileMap and rebuilds the rects of its chunk only
+    void setTile(flecs::entity map, int x, int y, bool solid);
+
+    // Worker threads for broadphase build and narrowphase (0 = all cores).
+    // Pairs are oriented by entity id and contacts resolved in entity-pair order,
+    // results and events do not depend on it
+    void setPhysicsThreads(unsigned threads);
+    unsigned getPhysicsThreads() const { return jobs_.threadCount(); }
+
+    // Scene queries against the colliders of the last physics step (static,
+    // sleeping and moving). Thread-safe between steps. Static bodies come from
+    // their tree, moving ones from the broadphase of the current mode: grid cells
+    // inside the bounds of the moving bodies, the sorted intervals of sweep and
+    // prune, or the per-layer trees.
+    // raycast: closest hit of the segment (x0, y0) -> (x1, y1)
+    bool raycast(float x0, float y0, float x1, float y1, RayHit& hit, const QueryFilter& filter = {}) const;
+    // raycastAll: appends every hit sorted by fraction, returns their count
+    size_t raycastAll(float x0, float y0, float x1, float y1, std::vector<RayHit>& hits,
+                      const QueryFilter& filter = {}) const;
+    // raycastBatch: closest hit for each ray, spread over the physics threads
+    void raycastBatch(const Ray* rays, size_t count, RayHit* hits, const QueryFilter& filter = {});
+    // overlap: appends the entities whose collider overlaps the shape
+    size_t overlapCircle(float x, float y, float radius, std::vector<flecs::entity_t>& out,
+                         const QueryFilter& filter = {}) const;
+    size_t overlapRect(float x, float y, float width, float height, float angle,
+                       std::vector<flecs::entity_t>& out, const QueryFilter& filter = {}) const;
+    // shapeCast: first hit of the collider shape moved from (x, y) by (dx, dy).
+    // hit.x/y is the shape center at the impact. Bodies it starts in are ignored
+    bool shapeCast(const E_Collider& collider, float x, float y, float angle, float dx, float dy,
+                   RayHit& hit, const QueryFilter& filter = {}) const;
+
+    // Velocity iterations of the contact solver. Impulses are warm started from the
+    // last frame, so stacks settle with a few iterations
+    void setSolverIterations(int iterations);
+    int getSolverIterations() const { return solverIterations_; }
+
+    // Islands of touching bodies that stay slower than SLEEP_VELOCITY for
+    // TIME_TO_SLEEP get E_Asleep and cost nothing until woken: by a contact,
+    // by set<E_Velocity>/set<E_Transform>, or at the next update() when a
+    // get_mut write left a non-zero velocity or moved the body. A body without
+    // contacts only sleeps when it stopped, slow drift is kept
+    void setSleepEnabled(bool enabled); // disabling wakes everything
+    bool getSleepEnabled() const { return sleepEnabled_; }
+    void wake(flecs::entity e);
+
+    // Contacts of the physics steps of the last update() in resolve order
+    Span<E_CollisionEvent> collisionEvents() const { return {collisionEvents_.data(), collisionEvents_.size()}; }
+
+    // Trigger overlaps that started or ended in the physics steps of the last
+    // update(), once per change. Overlapping pairs that keep their pose skip the
+    // narrowphase, sleeping bodies stay inside static triggers
+    Span<E_TriggerEvent> triggerEvents() const { return {triggerEvents_.data(), triggerEvents_.size()}; }
+    // Bodies overlapping the trigger now ("stay"), appended to out
+    size_t getTriggerOverlaps(flecs::entity trigger, std::vector<flecs::entity_t>& out) const;
+    bool isInTrigger(flecs::entity trigger, flecs::entity other) const;
+
+    // Called after the physics step for every contact of e, with event.a == e.
+    // One callback per entity, setting a new one replaces it. Remove it before
+    // deleting e, and not from inside a callback
+    using CollisionCallback = std::function<void(const E_CollisionEvent&)>;
+    void onCollision(flecs::entity e, CollisionCallback callback);
+    void removeCollisionCallback(flecs::entity e);
 
 private:
     flecs::world world;
+    bool headless_ = false;
 
     // === Spatial Grid & Collision Members ===
-    static constexpr int CELL_SIZE = 128;
+    static constexpr int CELL_SIZE = 128;                // level 0, level k cells are CELL_SIZE * 4^k
+    static float cellSize(int level) { return (float)(CELL_SIZE << (2 * level)); }
+
+    BroadphaseMode broadphaseMode_ = BroadphaseMode::Grid;
+
+    FlatGrid grid_;
+    uint32_t levelLayers_[MAX_GRID_LEVELS] = {};        // grid mode: layers with bodies on each level
+    Aabb dynamicBounds_ = {0, 0, 0, 0};                 // union of the bodies_ boxes, clips grid queries
+
+    SweepAndPrune sap_;
+    AabbTree trees_[MAX_LAYERS];                        // tree mode: one per layer
 
-    struct PairKey {
-        flecs::entity_t a, b;
-        bool operator==(const PairKey& o) const { return a == o.a && b == o.b; }
+    // collision layers
+    uint32_t layerMatrix_[MAX_LAYERS];                  // bit j of [i]: layer i collides with j
+    uint32_t activeLayers_ = 0;                         // layers with moving bodies this frame
+    std::vector<uint32_t> layerBodies_[MAX_LAYERS];     // bodies_ indices per layer
+
+    // static colliders, never rebuilt per frame. Tree payload = slot in staticBodies_
+    AabbTree staticTree_;
+    flecs::observer staticSync_;
+    std::vector<PhysicsBody> staticBodies_;
+    std::vector<uint32_t> freeStaticSlots_;
+    std::unordered_map<flecs::entity_t, uint32_t> staticSlots_;
+
+    // tile maps: merged rects are static bodies without a staticSlots_ entry,
+    // their tree key is TILE_PROXY_BIT | slot (entity ids never have bit 63)
+    static constexpr flecs::entity_t TILE_PROXY_BIT = 1ull << 63;
+    struct TileMapBodies {
+        int chunksX = 0, chunksY = 0;
+        std::vector<std::vector<uint32_t>> chunks;      // static slots per chunk
+    };
+    std::unordered_map<flecs::entity_t, TileMapBodies> tileMaps_;
+    flecs::observer tileMapSync_;
+    std::vector<uint8_t> tileUsed_;                     // greedy meshing scratch
+
+    // per-frame collision data, capacity is kept between frames
+    JobSystem jobs_;
+    std::vector<PhysicsBody> bodies_;                   // moving colliders
+    std::vector<BodyPair> pairs_;                       // broadphase candidates
+    std::vector<std::vector<BodyPair>> threadPairs_;    // grid pair search output per worker
+    std::vector<std::vector<Contact>> threadContacts_;  // narrowphase output per worker
+    std::vector<std::unique_ptr<NarrowphaseBatches>> threadBatches_; // batched kernel input per worker
+    std::vector<Contact> contacts_;                     // merged + sorted
+    std::vector<std::vector<Impact>> threadImpacts_;    // bullet sweeps per worker
+    std::vector<Impact> impacts_;
+    static constexpr float IMPACT_DEPTH = 0.01f;        // contact depth at a time of impact (< POSITION_SLOP)
+
+    // contact solver
+    static constexpr float RESTITUTION_THRESHOLD = 1.0f; // slower approach doesn't bounce
+    static constexpr float POSITION_SLOP = 0.5f;         // allowed penetration
+    static constexpr float POSITION_CORRECTION = 0.8f;   // part of the rest pushed out per frame
+    int solverIterations_ = 8;
+    std::vector<ContactManifold> manifolds_;            // this frame, sorted by (lo, hi)
+    std::vector<ContactManifold> prevManifolds_;        // last frame, warm start source
+
+    // sleeping. Sleepers live in staticBodies_/staticTree_ with sleeping = true
+    static constexpr float SLEEP_VELOCITY = 2.0f;        // px/s
+    static constexpr float TIME_TO_SLEEP = 0.5f;         // s
+    bool sleepEnabled_ = true;
+    flecs::observer wakeSync_;
+    std::vector<flecs::entity_t> wakeList_;             // sleepers touched this frame
+    std::vector<uint32_t> islandParent_;                // union-find over bodies_
+    std::vector<float> islandIdle_;                     // per island root
+
+    // fixed step
+    float fixedDt_ = 1.0f / 60.0f;
+    int maxSubsteps_ = 5;
+    float accumulator_ = 0.0f;
+    flecs::system integrateSystem_;
+
+    // integration, bodies with E_Velocity in SoA form (see BodyStore)
+    struct IntegrateTable {
+        E_Transform* transforms;
+        E_Velocity* velocities;
+        const E_Gravity* gravity;   // nullptr if the table has no E_Gravity
+        uint32_t first;             // index of its first body in bodyStore_
     };
+    BodyStore bodyStore_;
+    std::vector<IntegrateTable> integrateTables_;
+    flecs::system collisionSystem_;
 
-    struct PairHash {
-        std::size_t operator()(const PairKey& p) const noexcept {
-            auto h1 = std::hash<uint64_t>{}(p.a);
-            auto h2 = std::hash<uint64_t>{}(p.b);
-            return h1 ^ (h2 + 0x9e3779b97f4a7c15ull + (h1 << 6) + (h1 >> 2));
-        }
+    // mouse picking, pick tree payload = slot in pickEntities_/pickBoxes_
+    struct ScreenToWorld {
+        float scale = 1.0f;
+        float offsetX = 0.0f, offsetY = 0.0f;
     };
+    ScreenToWorld screenToWorld_;
+    float mouseWorldX_ = 0.0f, mouseWorldY_ = 0.0f;
+    AabbTree pickTree_;
+    flecs::observer pickSync_;
+    std::vector<flecs::entity_t> pickEntities_;
+    std::vector<Aabb> pickBoxes_;                       // sprite box, the tree keeps a fat one
+    std::vector<uint32_t> freePickSlots_;
+    std::unordered_map<flecs::entity_t, uint32_t> pickSlots_;
+    std::vector<flecs::entity_t> hovered_;
+    std::vector<flecs::entity_t> prevHovered_;
+
+    // triggers
+    std::vector<TriggerTest> triggerTests_;             // last step, sorted, read by the narrowphase
+    std::vector<std::vector<TriggerTest>> threadTriggerTests_;
+    std::vector<TriggerPair> triggerPairs_;             // overlapping now
+    std::vector<TriggerPair> prevTriggerPairs_;
+    std::vector<E_TriggerEvent> triggerEvents_;
+
+    // statistics. Workers count into their own line, merged at the end of update()
+    struct alignas(64) WorkerCounters {
+        uint64_t cellPairs, aabbRejects, duplicatePairs;
+        uint64_t candidatePairs, satTests, batchedTests;
+    };
+    PhysicsStats stats_;
+    std::vector<WorkerCounters> threadCounters_;
+
+    std::vector<E_CollisionEvent> collisionEvents_;
+    std::unordered_map<flecs::entity_t, CollisionCallback> collisionCallbacks_;
+
+    void syncStaticCollider(flecs::entity e, const E_Transform& t, const E_Collider& c);
+    void removeStaticBody(flecs::entity_t id);
+    uint32_t staticSlot(flecs::entity_t id);            // finds or allocates
+    uint32_t allocateStaticSlot();
+    void buildTileMap(flecs::entity e, const E_Transform& t, const E_TileMap& map);
+    void buildTileChunk(flecs::entity e, const E_Transform& t, const E_TileMap& map,
+                        int chunkX, int chunkY, std::vector<uint32_t>& slots);
+    void removeTileMap(flecs::entity_t id);
+
+    static float boundingRadius(const E_Collider& c);
+
+    // Collision pipeline stages (CollisionSystem)
+    void gatherBodies(float dt);
+    void buildBroadphase();
+    void findCandidatePairs();
+    void runNarrowphase();
+    void resolveImpacts();
+    void updateTriggers(flecs::world& w);
+    void resolveContacts(flecs::world& w);
+    void warmStartManifolds();
+    void solveManifolds();
+    void correctPositions();
+    PhysicsBody& manifoldBodyB(const ContactManifold& m);
+    void updateSleep(flecs::world& w, float dt);
+    void putToSleep(flecs::world& w, const PhysicsBody& body);
+    void wakeChangedSleepers();
+    void dispatchCollisionCallbacks(size_t firstEvent);
+    void storePrevTransforms();
+    void integrate(float dt, uint32_t count);
+
+    void updatePicking(flecs::world w);
+    void syncPickable(flecs::entity e, const E_Transform& t, const E_Sprite& s);
+    void removePickable(flecs::entity_t id);
+    uint32_t pickSlot(flecs::entity_t id);              // finds or allocates
 
-    std::unordered_map<long long, std::vector<flecs::entity_t>> grid_;
-    std::vector<flecs::entity_t> bigBodies_;
-    std::unordered_set<PairKey, PairHash> testedPairs_;
+    // scene query helpers (defined in ecs_world.cpp)
+    template<typename F> void walkRay(float px, float py, float dx, float dy, uint32_t layers, F&& f) const;
+    template<typename F> void walkBox(const Aabb& box, uint32_t layers, F&& f) const;
+    size_t overlapShape(const WorldShape& shape, std::vector<flecs::entity_t>& out, const QueryFilter& filter) const;
     
     // Cached query for optimization
-    flecs::query<E_Transform, E_Collider> qColliders_;
+    flecs::query<E_Transform, E_Collider, E_Velocity*, E_Mass*, E_PhysicsMaterial*, E_Sleep*,
+                 const E_PrevTransform*> qDynamic_; // colliders without E_StaticCollider/E_Asleep
+    flecs::query<const E_Transform, const E_Velocity*> qAsleep_;
+    flecs::query<const E_Transform, E_PrevTransform*> qPrevTransform_; // bodies with E_Velocity
     flecs::query<E_Transform, E_Camera> qCamera_;
+    flecs::query<const E_Transform, const E_Sprite> qPickMoving_; // pickables with E_Velocity
 
 };
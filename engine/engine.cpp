@@ -22,30 +22,38 @@ Engine::~Engine() { shutdown(); }
 // ================= Init and shutdown ================= 
 
 bool Engine::init(int w, int h, BackGroundColor c) {
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW\n";
-        return false;
-    }
+    window_w = w; window_h = h; background_color = c;
+    textureManager.setHeadless(headless);
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    if (!headless) {
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW\n";
+            return false;
+        }
 
-    window_w = w; window_h = h; background_color = c;
-    ui.init(window_w, window_h);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+
+        ui.init(window_w, window_h);
+    } else if (debugMode) {
+        printf("[Engine] Headless mode, no window\n");
+    }
 
     // init ecs
-    ecs.init();  // ECS components and base systems
+    ecs.init(headless);  // ECS components and base systems
     ecs.getWorld().set<E_WindowSize>({window_w, window_h});
 
     return true;
 }
 
 void Engine::shutdown() {
+    if (headless) return;
     if (window) glfwDestroyWindow(window);
     glfwTerminate();
 }
 // ================= Window ================= 
 bool Engine::createWindow(const char* title) {
+    if (headless) return true; // nothing to create, scenes run the same
     if(debugMode) printf("[Engine] Creating window\n");
     window = glfwCreateWindow(window_w, window_h, title, nullptr, nullptr);
     if (!window) {
@@ -95,13 +103,14 @@ bool Engine::createWindow(const char* title) {
 
 void Engine::window_freezeSize(GLFWwindow* win, int w, int h){
     window_changeSize(win, w, h);
+    if (headless) return;
     glfwSetWindowSizeLimits(win, w, h, w, h);
     glfwSetWindowAttrib(window, GLFW_RESIZABLE, GLFW_FALSE);
 }
 
 void Engine::window_changeSize(GLFWwindow* win, int w, int h, bool funMode) {
     if (!win) win = window; // if null, just change main window
-    glfwSetWindowSize(win, w, h);
+    if (!headless) glfwSetWindowSize(win, w, h);
 
     // update Ortho
     if (win == window) {
@@ -109,7 +118,7 @@ void Engine::window_changeSize(GLFWwindow* win, int w, int h, bool funMode) {
         window_h = h;
         ecs.getWorld().set<E_WindowSize>({window_w, window_h});
         // For fun can comment it 
-        if(!funMode) glViewport(0, 0, w, h);
+        if(!funMode && !headless) glViewport(0, 0, w, h);
     }
 }
 
@@ -117,7 +126,7 @@ void Engine::window_changeSize(GLFWwindow* win, int w, int h, bool funMode) {
 
 void Engine::SetVSync(bool turnOn) {
     VSync = turnOn;
-    glfwSwapInterval(turnOn ? 1 : 0);
+    if (!headless) glfwSwapInterval(turnOn ? 1 : 0);
 }
 
 void Engine::MaxFPS(int maxFPS) {
@@ -137,7 +146,8 @@ float Engine::getFPS() { return 1.f / currentDt; }
 // ================= Time and input ================= 
 
 bool Engine::tick() {
-    if (glfwWindowShouldClose(window)) return false;
+    if (quitRequested) return false;
+    if (!headless && glfwWindowShouldClose(window)) return false;
 
     static auto lastTime = std::chrono::high_resolution_clock::now();
     auto now = std::chrono::high_resolution_clock::now();
@@ -169,21 +179,24 @@ bool Engine::tick() {
     
     // Safe from the big dt(for ex., when move the window)
     if (dt > 0.1f) dt = 0.1f;
+    if (tickDelta > 0.0f) dt = tickDelta;
     
     currentDt = dt;
 
     processInput();
     if (onInput) onInput();
 
-    render();
+    if (!headless) render();
 
     update(dt);
     if (onUpdate) onUpdate(dt);
 
-    if (onRender) onRender();
+    if (!headless) {
+        if (onRender) onRender();
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
 
     // safe reload scene
     if (!pendingSceneLoad.empty()) {
@@ -191,6 +204,7 @@ bool Engine::tick() {
         pendingSceneLoad = "";
     }
 
+    ++frame;
     return true;
 }
 
@@ -218,9 +232,11 @@ void Engine::render() {
 
 template<typename... Components>
 flecs::entity Engine::addRenderSystem(std::string name, std::function<void(flecs::entity, Components&...)> func) {
-    return ecs.getWorld().system<Components...>(name.c_str())
+    flecs::entity system = ecs.getWorld().system<Components...>(name.c_str())
         .each(func)
         .term_at(0).moved().add(EcsOnStore);
+    if (headless) system.disable(); // nothing to draw into
+    return system;
 }
 
 template<typename... Components>
@@ -298,30 +314,44 @@ void Engine::_performLoadScene(const std::string& name) {
 void Engine::processInput() {
     E_InputState& input = ecs.getWorld().get_mut<E_InputState>(); 
 
+    // raw state of this tick: the script/replay when headless, else the window
+    if (headless) {
+        if (inputSource) inputSource(frame, rawInput);
+    } else {
+        double mx, my;
+        glfwGetCursorPos(window, &mx, &my);
+        rawInput.mouseX = mx;
+        rawInput.mouseY = my;
+        rawInput.leftDown = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+        rawInput.rightDown = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS);
+
+        // 350 keys its many, but it anyway faster
+        for (int key = 0; key < 350; ++key) {
+            // for the simple API it'll check every 350 keys its like < 1 microsec
+            rawInput.keysDown[key] = (glfwGetKey(window, key) == GLFW_PRESS);
+        }
+    }
+    if (onInputFrame) onInputFrame(frame, rawInput);
+
     // --- MOUSE ---
-    double mx, my;
-    glfwGetCursorPos(window, &mx, &my);
-    bool curLeft = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
-    bool curRight = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS);
+    bool curLeft = rawInput.leftDown;
+    bool curRight = rawInput.rightDown;
 
     input.leftPressed = curLeft && !input._prevLeftDown;
     input.leftReleased = !curLeft && input._prevLeftDown;
     input.rightPressed = curRight && !input._prevRightDown;
     input.rightReleased = !curRight && input._prevRightDown;
 
-    input.mouseX = mx;
-    input.mouseY = my;
+    input.mouseX = rawInput.mouseX;
+    input.mouseY = rawInput.mouseY;
     input.leftDown = curLeft;
     input.rightDown = curRight;
     input._prevLeftDown = curLeft;
     input._prevRightDown = curRight;
 
     // --- KEYBOARD ---
-    // 350 keys its many, but it anyway faster
     for (int key = 0; key < 350; ++key) {
-        // for the simple API it'll check every 350 keys its like < 1 microsec
-
-        bool isDown = (glfwGetKey(window, key) == GLFW_PRESS);
+        bool isDown = rawInput.keysDown[key];
 
         input.keysPressed[key] = isDown && !input._prevKeysDown[key];
         input.keysReleased[key] = !isDown && input._prevKeysDown[key];
@@ -46,6 +46,13 @@ public:
     void SetDebugMode(bool s) { debugMode = s; }
     bool isDebugMode() const { return debugMode; }
 
+    // Headless mode, set before init(): no GLFW, GL context, RmlUi or ImGui.
+    // The ECS pipeline runs without the render systems (CameraSystem, RenderSystem,
+    // addRenderSystem), input comes from inputSource, onRender is not called and
+    // tick() runs until quit(). For simulation servers and CI runs
+    void SetHeadless(bool s) { headless = s; }
+    bool isHeadless() const { return headless; }
+
     E_Color ReturnColor(ColorRGB c) {return E_Color{c.r, c.g, c.b};}
 
     // Entity
@@ -62,6 +69,12 @@ public:
     std::function<void()> onRender;
     std::function<void()> onInput;
 
+    // Headless input (script or replay): fills the raw input of tick `frame`,
+    // the state of the previous tick is passed in
+    std::function<void(uint64_t frame, InputFrame& input)> inputSource;
+    // Raw input of every tick, e.g. recorded in a window and replayed headless
+    std::function<void(uint64_t frame, const InputFrame& input)> onInputFrame;
+
     // Custom ECS systems 
     template<typename... Components>
     flecs::entity addRenderSystem(std::string name, std::function<void(flecs::entity, Components&...)> func);
@@ -79,6 +92,10 @@ public:
 
 
     bool tick();
+    void quit() { quitRequested = true; } // the next tick() returns false
+    // Fixed dt per tick instead of the clock (0 = clock), for replays and benchmarks
+    void SetTickDelta(float dt) { tickDelta = dt; }
+    uint64_t getFrame() const { return frame; } // ticks done
 
     // Input Helpers
     bool isKeyDown(int key);     // is down
@@ -112,6 +129,8 @@ private:
     GLFWwindow* window = nullptr;
     ECSWorld ecs;
     bool debugMode = false;
+    bool headless = false;
+    bool quitRequested = false;
 
     std::vector<WindowData> windows; // windows[0] is the main window
 
@@ -129,7 +148,10 @@ private:
 
     float currentDt = 0.0f;
     float targetFrameTime = 0.0f;
+    float tickDelta = 0.0f;
     bool VSync = false;
+    uint64_t frame = 0;
+    InputFrame rawInput;
 
     // functions
     void processInput();
@@ -0,0 +1,92 @@
+//
+//  job_system.cpp rbashkort 16/10/2026
+//
+
+#include "job_system.h"
+
+JobSystem::JobSystem(unsigned threads) {
+    setThreadCount(threads);
+}
+
+JobSystem::~JobSystem() {
+    stopWorkers();
+}
+
+void JobSystem::setThreadCount(unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads == threadCount()) return;
+
+    stopWorkers();
+    startWorkers(threads - 1);
+}
+
+void JobSystem::startWorkers(unsigned count) {
+    quit_ = false;
+    for (unsigned i = 0; i < count; ++i) {
+        workers_.emplace_back(&JobSystem::workerLoop, this, i + 1);
+    }
+}
+
+void JobSystem::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_) t.join();
+    workers_.clear();
+}
+
+void JobSystem::run(uint32_t count, uint32_t minChunk, TaskFn fn, void* ctx) {
+    // ~4 chunks per thread keeps the load balanced without much overhead
+    uint32_t chunk = count / (threadCount() * 4);
+    if (chunk < minChunk) chunk = minChunk;
+    if (chunk == 0) chunk = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fn_ = fn;
+        ctx_ = ctx;
+        count_ = count;
+        chunk_ = chunk;
+        next_.store(0);
+        busy_.store((unsigned)workers_.size());
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_.load() == 0; });
+    fn_ = nullptr;
+}
+
+void JobSystem::drain(unsigned worker) {
+    for (;;) {
+        uint32_t begin = next_.fetch_add(chunk_);
+        if (begin >= count_) break;
+        uint32_t end = begin + chunk_ < count_ ? begin + chunk_ : count_;
+        fn_(ctx_, begin, end, worker);
+    }
+}
+
+void JobSystem::workerLoop(unsigned worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return quit_ || generation_ != seen; });
+            if (quit_) return;
+            seen = generation_;
+        }
+
+        drain(worker);
+
+        if (busy_.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.notify_one();
+        }
+    }
+}
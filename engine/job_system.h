@@ -0,0 +1,66 @@
+//
+//  job_system.h rbashkort 16/10/2026
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small persistent worker pool for data-parallel loops (physics).
+// The calling thread takes part in the work as worker 0, so per-thread
+// buffers can be indexed with the worker index in [0, threadCount()).
+class JobSystem {
+public:
+    explicit JobSystem(unsigned threads = 0); // 0 = hardware concurrency
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void setThreadCount(unsigned threads);
+    unsigned threadCount() const { return (unsigned)workers_.size() + 1; }
+
+    // Calls f(begin, end, worker) for chunks of [0, count) and blocks until all
+    // chunks are done. Chunks are at least minChunk items big.
+    template<typename F>
+    void parallelFor(uint32_t count, uint32_t minChunk, F&& f) {
+        if (count == 0) return;
+        if (workers_.empty() || count <= minChunk) {
+            f(0u, count, 0u);
+            return;
+        }
+        auto trampoline = [](void* ctx, uint32_t begin, uint32_t end, unsigned worker) {
+            (*static_cast<F*>(ctx))(begin, end, worker);
+        };
+        run(count, minChunk, trampoline, &f);
+    }
+
+private:
+    using TaskFn = void (*)(void*, uint32_t, uint32_t, unsigned);
+
+    void run(uint32_t count, uint32_t minChunk, TaskFn fn, void* ctx);
+    void workerLoop(unsigned worker);
+    void drain(unsigned worker);
+    void startWorkers(unsigned count);
+    void stopWorkers();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    // current job
+    TaskFn fn_ = nullptr;
+    void* ctx_ = nullptr;
+    uint32_t count_ = 0;
+    uint32_t chunk_ = 1;
+    std::atomic<uint32_t> next_{0};
+    std::atomic<unsigned> busy_{0};
+    uint64_t generation_ = 0;
+    bool quit_ = false;
+};
@@ -1,6 +1,7 @@
 #include <cmath>
 #include <cfloat>
 #include "components.h"
+#include "collision.h"
 
 struct Vec2 { float x, y; };
 
@@ -190,3 +191,558 @@ bool satCircleCircle(Vec2 c1, float r1, Vec2 c2, float r2, Vec2& mtv) {
     return true;
 }
 
+// === Cached world shapes ===
+
+// Fills the world-space shape of a collider. Zero-angle bodies skip the trig,
+// rotated ones pay a single cos/sin instead of one per vertex.
+void computeWorldShape(const E_Transform& t, const E_Collider& c, WorldShape& out) {
+    out.cx = out.mx = t.x + c.offsetX;
+    out.cy = out.my = t.y + c.offsetY;
+    out.count = 0;
+    out.hull = nullptr;
+
+    if (c.type == ColliderType::Circle) {
+        out.radius = c.radius;
+        return;
+    }
+
+    float cs = 1.0f, sn = 0.0f;
+    if (t.angle != 0.0f) {
+        float rad = t.angle * 0.0174532925f;
+        cs = cosf(rad);
+        sn = sinf(rad);
+    }
+
+    if (c.type == ColliderType::Polygon) {
+        const ConvexPolygon& poly = getPolygon(c.polygon);
+        if (poly.count == 0) { // no polygon: behaves as a circle
+            out.radius = c.radius;
+            return;
+        }
+        out.hull = &poly;
+        out.cs = cs;
+        out.sn = sn;
+        out.radius = poly.radius;
+        out.mx = out.cx + (poly.cx * cs - poly.cy * sn);
+        out.my = out.cy + (poly.cx * sn + poly.cy * cs);
+        return;
+    }
+
+    float hw = c.width * 0.5f;
+    float hh = c.height * 0.5f;
+    out.radius = sqrtf(hw * hw + hh * hh);
+
+    Vec2 local[4];
+    if (c.type == ColliderType::Rect) {
+        local[0] = {-hw, -hh}; local[1] = { hw, -hh};
+        local[2] = { hw,  hh}; local[3] = {-hw,  hh};
+        out.count = 4;
+    } else if (c.type == ColliderType::Triangle) {
+        local[0] = {  0, -hh}; local[1] = {-hw,  hh}; local[2] = { hw,  hh};
+        out.count = 3;
+    } else {
+        return;
+    }
+
+    float sumX = 0.0f, sumY = 0.0f;
+    for (int i = 0; i < out.count; ++i) {
+        out.vx[i] = out.cx + (local[i].x * cs - local[i].y * sn);
+        out.vy[i] = out.cy + (local[i].x * sn + local[i].y * cs);
+        sumX += out.vx[i];
+        sumY += out.vy[i];
+    }
+    out.mx = sumX / out.count;
+    out.my = sumY / out.count;
+
+    for (int i = 0; i < out.count; ++i) {
+        int j = (i + 1) % out.count;
+        Vec2 axis = normalize(perp({out.vx[j] - out.vx[i], out.vy[j] - out.vy[i]}));
+        out.nx[i] = axis.x;
+        out.ny[i] = axis.y;
+    }
+}
+
+void projectShape(const WorldShape& s, Vec2 axis, float& minOut, float& maxOut) {
+    minOut = maxOut = s.vx[0] * axis.x + s.vy[0] * axis.y;
+    for (int i = 1; i < s.count; ++i) {
+        float p = s.vx[i] * axis.x + s.vy[i] * axis.y;
+        if (p < minOut) minOut = p;
+        if (p > maxOut) maxOut = p;
+    }
+}
+
+// satPolyPoly on cached shapes
+bool satShapeShape(const WorldShape& A, const WorldShape& B, Vec2& mtv) {
+    float overlap = FLT_MAX;
+    Vec2 smallestAxis = {0, 0};
+
+    auto testAxes = [&](const WorldShape& shape) -> bool {
+        for (int i = 0; i < shape.count; ++i) {
+            Vec2 axis = {shape.nx[i], shape.ny[i]};
+            if (lenSq(axis) < 1e-8f) continue;
+
+            float minA, maxA, minB, maxB;
+            projectShape(A, axis, minA, maxA);
+            projectShape(B, axis, minB, maxB);
+
+            if (maxA < minB || maxB < minA) return false;
+
+            float o = fminf(maxA, maxB) - fmaxf(minA, minB);
+            if (o < overlap) {
+                overlap = o;
+                smallestAxis = axis;
+            }
+        }
+        return true;
+    };
+
+    if (!testAxes(A)) return false;
+    if (!testAxes(B)) return false;
+
+    Vec2 dir = {B.mx - A.mx, B.my - A.my};
+    if (dot(dir, smallestAxis) < 0) smallestAxis = mul(smallestAxis, -1);
+
+    mtv = mul(smallestAxis, overlap);
+    return true;
+}
+
+// satCirclePoly on a cached shape, mtv pushes the circle out of the polygon
+bool satCircleShape(Vec2 center, float radius, const WorldShape& poly, Vec2& mtv) {
+    float overlap = FLT_MAX;
+    Vec2 smallestAxis = {0, 0};
+
+    auto testAxis = [&](Vec2 axis) -> bool {
+        float minP, maxP;
+        projectShape(poly, axis, minP, maxP);
+
+        float projC = dot(center, axis);
+        float minC = projC - radius;
+        float maxC = projC + radius;
+
+        if (maxP < minC || maxC < minP) return false;
+
+        float o = fminf(maxP, maxC) - fmaxf(minP, minC);
+        if (o < overlap) {
+            overlap = o;
+            smallestAxis = axis;
+        }
+        return true;
+    };
+
+    for (int i = 0; i < poly.count; ++i) {
+        Vec2 axis = {poly.nx[i], poly.ny[i]};
+        if (lenSq(axis) < 1e-8f) continue;
+        if (!testAxis(axis)) return false;
+    }
+
+    int closest = 0;
+    float minDst = lenSq({center.x - poly.vx[0], center.y - poly.vy[0]});
+    for (int i = 1; i < poly.count; ++i) {
+        float d = lenSq({center.x - poly.vx[i], center.y - poly.vy[i]});
+        if (d < minDst) {
+            minDst = d;
+            closest = i;
+        }
+    }
+
+    Vec2 axis = normalize({center.x - poly.vx[closest], center.y - poly.vy[closest]});
+    if (lenSq(axis) > 1e-8f && !testAxis(axis)) return false;
+
+    Vec2 dir = {center.x - poly.mx, center.y - poly.my};
+    if (dot(dir, smallestAxis) < 0) smallestAxis = mul(smallestAxis, -1);
+
+    mtv = mul(smallestAxis, overlap);
+    return true;
+}
+// === GJK / EPA ===
+// Pool polygons are only touched through support points, so a test costs
+// O(vertices) per iteration instead of SAT's O(edges * vertices). Circles are
+// points with a margin (their radius). Rects and triangles work too, they
+// take this path when paired with a pool polygon.
+
+// Farthest point of the shape core in direction d
+Vec2 supportPoint(const WorldShape& s, Vec2 d) {
+    if (s.hull) {
+        const ConvexPolygon& p = *s.hull;
+        float lx = d.x * s.cs + d.y * s.sn;  // d in local space
+        float ly = d.y * s.cs - d.x * s.sn;
+        int best = 0;
+        float bestDot = p.x[0] * lx + p.y[0] * ly;
+        for (int i = 1; i < p.count; ++i) {
+            float v = p.x[i] * lx + p.y[i] * ly;
+            if (v > bestDot) { bestDot = v; best = i; }
+        }
+        return {s.cx + (p.x[best] * s.cs - p.y[best] * s.sn), s.cy + (p.x[best] * s.sn + p.y[best] * s.cs)};
+    }
+    if (s.count > 0) {
+        int best = 0;
+        float bestDot = s.vx[0] * d.x + s.vy[0] * d.y;
+        for (int i = 1; i < s.count; ++i) {
+            float v = s.vx[i] * d.x + s.vy[i] * d.y;
+            if (v > bestDot) { bestDot = v; best = i; }
+        }
+        return {s.vx[best], s.vy[best]};
+    }
+    return {s.cx, s.cy};
+}
+
+inline float shapeMargin(const WorldShape& s) { return s.hull || s.count > 0 ? 0.0f : s.radius; }
+inline float cross(Vec2 a, Vec2 b) { return a.x * b.y - a.y * b.x; }
+
+// Point of the Minkowski difference A - (B + offsetB)
+inline Vec2 supportAB(const WorldShape& A, const WorldShape& B, Vec2 offsetB, Vec2 d) {
+    return sub(supportPoint(A, d), add(supportPoint(B, mul(d, -1)), offsetB));
+}
+
+struct GjkSimplex {
+    Vec2 w[3];
+    int count = 0;
+};
+
+// Closest point of the simplex to the origin, drops the vertices not needed
+// for it (Voronoi regions, as in Box2D's b2Simplex). Returns {0, 0} with
+// count = 3 when the triangle holds the origin
+Vec2 solveSimplex(GjkSimplex& s) {
+    if (s.count == 1) return s.w[0];
+
+    if (s.count == 2) {
+        Vec2 a = s.w[0], b = s.w[1];
+        Vec2 e = sub(b, a);
+        float ua = dot(b, e), ub = -dot(a, e);
+        if (ub <= 0.0f) { s.count = 1; return a; }
+        if (ua <= 0.0f) { s.w[0] = b; s.count = 1; return b; }
+        return mul(add(mul(a, ua), mul(b, ub)), 1.0f / (ua + ub));
+    }
+
+    Vec2 a = s.w[0], b = s.w[1], c = s.w[2];
+    Vec2 eab = sub(b, a), eac = sub(c, a), ebc = sub(c, b);
+    float ab1 = dot(b, eab), ab2 = -dot(a, eab);
+    float ac1 = dot(c, eac), ac2 = -dot(a, eac);
+    float bc1 = dot(c, ebc), bc2 = -dot(b, ebc);
+    float area = cross(eab, eac);
+    float abc1 = area * cross(b, c), abc2 = area * cross(c, a), abc3 = area * cross(a, b);
+
+    if (ab2 <= 0.0f && ac2 <= 0.0f) { s.count = 1; return a; }
+    if (ab1 > 0.0f && ab2 > 0.0f && abc3 <= 0.0f) {
+        s.count = 2;
+        return mul(add(mul(a, ab1), mul(b, ab2)), 1.0f / (ab1 + ab2));
+    }
+    if (ac1 > 0.0f && ac2 > 0.0f && abc2 <= 0.0f) {
+        s.w[1] = c; s.count = 2;
+        return mul(add(mul(a, ac1), mul(c, ac2)), 1.0f / (ac1 + ac2));
+    }
+    if (ab1 <= 0.0f && bc2 <= 0.0f) { s.w[0] = b; s.count = 1; return b; }
+    if (ac1 <= 0.0f && bc1 <= 0.0f) { s.w[0] = c; s.count = 1; return c; }
+    if (bc1 > 0.0f && bc2 > 0.0f && abc1 <= 0.0f) {
+        s.w[0] = b; s.w[1] = c; s.count = 2;
+        return mul(add(mul(b, bc1), mul(c, bc2)), 1.0f / (bc1 + bc2));
+    }
+    return {0, 0};
+}
+
+// Distance between the cores of A and B shifted by offsetB, n is the unit
+// normal from A to B. Returns false if the cores overlap or touch
+bool gjkDistance(const WorldShape& A, const WorldShape& B, Vec2 offsetB, GjkSimplex& s, float& dist, Vec2& n) {
+    Vec2 d = sub(add({B.cx, B.cy}, offsetB), {A.cx, A.cy});
+    if (lenSq(d) < 1e-12f) d = {1, 0};
+    s.w[0] = supportAB(A, B, offsetB, mul(d, -1));
+    s.count = 1;
+    Vec2 v = s.w[0];
+
+    for (int iter = 0; iter < 32; ++iter) {
+        float vv = lenSq(v);
+        if (vv < 1e-10f) return false;
+
+        Vec2 w = supportAB(A, B, offsetB, mul(v, -1));
+        if (vv - dot(v, w) <= 1e-5f * vv) break; // no progress, v is the closest point
+
+        bool repeated = false;
+        for (int i = 0; i < s.count; ++i) repeated |= (s.w[i].x == w.x && s.w[i].y == w.y);
+        if (repeated) break;
+
+        s.w[s.count++] = w;
+        v = solveSimplex(s);
+        if (s.count == 3) return false;
+    }
+
+    dist = len(v);
+    n = mul(v, -1.0f / dist);
+    return true;
+}
+
+// Penetration of overlapping cores from the GJK simplex: the face of A - B
+// closest to the origin. n is the unit normal from A to B
+bool epa(const WorldShape& A, const WorldShape& B, const GjkSimplex& s, Vec2& n, float& depth) {
+    constexpr int MAX_EPA_VERTICES = 2 * MAX_POLYGON_VERTICES + 8;
+    if (s.count < 3) return false;
+
+    Vec2 poly[MAX_EPA_VERTICES];
+    int count = 3;
+    poly[0] = s.w[0];
+    poly[1] = s.w[1];
+    poly[2] = s.w[2];
+    float area = cross(sub(poly[1], poly[0]), sub(poly[2], poly[0]));
+    if (fabsf(area) < 1e-8f) return false;
+    if (area < 0.0f) { Vec2 tmp = poly[1]; poly[1] = poly[2]; poly[2] = tmp; } // counter-clockwise
+
+    for (int iter = 0; iter < 32; ++iter) {
+        int edge = -1;
+        float best = FLT_MAX;
+        Vec2 bestN = {0, 0};
+        for (int i = 0; i < count; ++i) {
+            Vec2 e = sub(poly[(i + 1) % count], poly[i]);
+            Vec2 normal = normalize({e.y, -e.x}); // outward
+            if (lenSq(normal) < 1e-8f) continue;
+            float dist = dot(normal, poly[i]);
+            if (dist < best) { best = dist; bestN = normal; edge = i; }
+        }
+        if (edge < 0) return false;
+
+        n = bestN;
+        depth = best;
+        Vec2 w = supportAB(A, B, {0, 0}, bestN);
+        if (dot(w, bestN) - best < 1e-4f || count == MAX_EPA_VERTICES) return true;
+
+        for (int i = count; i > edge + 1; --i) poly[i] = poly[i - 1];
+        poly[edge + 1] = w;
+        ++count;
+    }
+    return true;
+}
+
+// Contact when at least one shape is a pool polygon, mtv pushes B out of A
+bool gjkShapeShape(const WorldShape& A, const WorldShape& B, Vec2& mtv) {
+    const float margin = shapeMargin(A) + shapeMargin(B);
+    GjkSimplex s;
+    float dist;
+    Vec2 n;
+    if (gjkDistance(A, B, {0, 0}, s, dist, n)) {
+        if (dist >= margin) return false;
+        mtv = mul(n, margin - dist);
+        return true;
+    }
+
+    float depth;
+    if (!epa(A, B, s, n, depth)) {
+        // cores just touch: push along the centers
+        n = normalize({B.mx - A.mx, B.my - A.my});
+        if (lenSq(n) < 1e-8f) n = {1, 0};
+        depth = 0.0f;
+    }
+    mtv = mul(n, depth + margin);
+    return true;
+}
+
+// Conservative advancement: the distance of two convex shapes under a
+// translation is convex in t, so stepping by gap / closing speed never passes
+// the impact
+bool toiGjk(const WorldShape& A, const WorldShape& B, Vec2 d, float& t, Vec2& n) {
+    constexpr float TOI_TOLERANCE = 0.005f;
+    const float margin = shapeMargin(A) + shapeMargin(B);
+
+    float time = 0.0f;
+    for (int iter = 0; iter < 32; ++iter) {
+        GjkSimplex s;
+        float dist;
+        Vec2 dir;
+        if (!gjkDistance(A, B, mul(d, time - 1.0f), s, dist, dir) || dist - margin <= 0.0f) {
+            if (iter == 0) return false; // overlapping from the start
+            t = time;                    // float error past the surface, n is from the last step
+            return true;
+        }
+        n = dir;
+        float gap = dist - margin;
+        if (gap < TOI_TOLERANCE) {
+            t = time;
+            return true;
+        }
+
+        float closing = -dot(d, dir);
+        if (closing <= 1e-8f) return false; // moving apart
+        time += gap / closing;
+        if (time > 1.0f) return false;
+    }
+    return false; // grazing, never got close enough
+}
+
+// Segment p + d * t against a pool polygon (clipped by every edge in local space)
+bool raycastHull(const WorldShape& s, Vec2 p, Vec2 d, float& t, Vec2& n) {
+    const ConvexPolygon& poly = *s.hull;
+    Vec2 lp = {(p.x - s.cx) * s.cs + (p.y - s.cy) * s.sn, (p.y - s.cy) * s.cs - (p.x - s.cx) * s.sn};
+    Vec2 ld = {d.x * s.cs + d.y * s.sn, d.y * s.cs - d.x * s.sn};
+
+    float enter = 0.0f, exit = 1.0f;
+    int enterEdge = -1;
+    for (int i = 0; i < poly.count; ++i) {
+        Vec2 normal = {poly.nx[i], poly.ny[i]};
+        float num = dot(normal, {poly.x[i] - lp.x, poly.y[i] - lp.y});
+        float den = dot(normal, ld);
+        if (den == 0.0f) {
+            if (num < 0.0f) return false; // parallel, outside
+            continue;
+        }
+        float ti = num / den;
+        if (den < 0.0f) {
+            if (ti > enter) { enter = ti; enterEdge = i; }
+        } else if (ti < exit) {
+            exit = ti;
+        }
+        if (enter > exit) return false;
+    }
+    if (enterEdge < 0) return false; // starts inside
+
+    t = enter;
+    n = {poly.nx[enterEdge] * s.cs - poly.ny[enterEdge] * s.sn, poly.nx[enterEdge] * s.sn + poly.ny[enterEdge] * s.cs};
+    return true;
+}
+
+// === Continuous collision (time of impact) ===
+// B moves by d relative to A and ends at its cached pose. t in [0, 1] is the
+// first touch along that motion, n the contact normal from A to B.
+// Shapes that already overlap at the start are not reported.
+
+bool toiCircleCircle(Vec2 cA, float rA, Vec2 cB, float rB, Vec2 d, float& t, Vec2& n) {
+    float R = rA + rB;
+    Vec2 m = sub(sub(cB, d), cA);          // B at the start, relative to A
+    float a = lenSq(d);
+    float b = 2.0f * dot(m, d);
+    float c = lenSq(m) - R * R;
+    if (a < 1e-12f || c < 0.0f) return false;
+
+    float disc = b * b - 4.0f * a * c;
+    if (disc < 0.0f) return false;
+
+    float hit = (-b - sqrtf(disc)) / (2.0f * a);
+    if (hit < 0.0f || hit > 1.0f) return false;
+
+    t = hit;
+    n = normalize(add(m, mul(d, hit)));
+    return true;
+}
+
+// Circle from c0 moving by d against the polygon, i.e. a ray against the
+// polygon rounded by r. n points out of the polygon
+bool toiCirclePoly(Vec2 c0, float r, Vec2 d, const WorldShape& poly, float& t, Vec2& n) {
+    float best = 2.0f;
+    Vec2 bestN = {0, 0};
+
+    for (int i = 0; i < poly.count; ++i) {
+        int j = (i + 1) % poly.count;
+        Vec2 p1 = {poly.vx[i], poly.vy[i]};
+        Vec2 p2 = {poly.vx[j], poly.vy[j]};
+        Vec2 edgeN = {poly.nx[i], poly.ny[i]};
+        if (lenSq(edgeN) < 1e-8f) continue;
+        if (dot(edgeN, sub(p1, {poly.mx, poly.my})) < 0) edgeN = mul(edgeN, -1); // outward
+
+        // edge pushed out by r
+        float denom = dot(d, edgeN);
+        float dist = dot(sub(c0, p1), edgeN) - r;
+        if (denom < 0.0f && dist >= 0.0f) {
+            float s = -dist / denom;
+            if (s <= 1.0f) {
+                Vec2 hit = add(c0, mul(d, s));
+                Vec2 edge = sub(p2, p1);
+                float u = dot(sub(hit, p1), edge) / lenSq(edge);
+                if (u >= 0.0f && u <= 1.0f && s < best) {
+                    best = s;
+                    bestN = edgeN;
+                }
+            }
+        }
+
+        // rounded corner
+        float tc; Vec2 nc;
+        if (toiCircleCircle(p1, 0.0f, add(c0, d), r, d, tc, nc) && tc < best) {
+            best = tc;
+            bestN = nc;
+        }
+    }
+
+    if (best > 1.0f) return false;
+    t = best;
+    n = bestN;
+    return true;
+}
+
+// Swept SAT: per axis the interval of t where the projections overlap,
+// the impact is the latest entry if it comes before the earliest exit
+bool toiPolyPoly(const WorldShape& A, const WorldShape& B, Vec2 d, float& t, Vec2& n) {
+    float enter = 0.0f, exit = 1.0f;
+    Vec2 enterN = {0, 0};
+    bool entered = false;
+
+    auto testAxes = [&](const WorldShape& shape) -> bool {
+        for (int i = 0; i < shape.count; ++i) {
+            Vec2 axis = {shape.nx[i], shape.ny[i]};
+            if (lenSq(axis) < 1e-8f) continue;
+
+            float minA, maxA, minB, maxB;
+            projectShape(A, axis, minA, maxA);
+            projectShape(B, axis, minB, maxB);
+
+            // B at time t is shifted by d * (t - 1)
+            float v = dot(d, axis);
+            float lo = minA - maxB, hi = maxA - minB; // overlap while d*(t-1) in [lo, hi]
+            if (fabsf(v) < 1e-8f) {
+                if (0.0f < lo || 0.0f > hi) return false;
+                continue;
+            }
+            float t0 = 1.0f + lo / v;
+            float t1 = 1.0f + hi / v;
+            if (t0 > t1) { float tmp = t0; t0 = t1; t1 = tmp; }
+
+            if (t0 > enter) {
+                enter = t0;
+                enterN = v < 0.0f ? axis : mul(axis, -1); // B came from the side it moves away from
+                entered = true;
+            }
+            if (t1 < exit) exit = t1;
+            if (enter > exit) return false;
+        }
+        return true;
+    };
+
+    if (!testAxes(A)) return false;
+    if (!testAxes(B)) return false;
+    if (!entered) return false; // overlapping from the start
+
+    t = enter;
+    n = enterN;
+    return true;
+}
+
+bool timeOfImpact(const WorldShape& A, const WorldShape& B, Vec2 d, float& t, Vec2& n) {
+    if (A.hull || B.hull) return toiGjk(A, B, d, t, n);
+
+    const bool polyA = A.count > 0;
+    const bool polyB = B.count > 0;
+
+    if (polyA && polyB) return toiPolyPoly(A, B, d, t, n);
+    if (!polyA && !polyB) return toiCircleCircle({A.cx, A.cy}, A.radius, {B.cx, B.cy}, B.radius, d, t, n);
+    if (polyA) {
+        return toiCirclePoly({B.cx - d.x, B.cy - d.y}, B.radius, d, A, t, n);
+    }
+    // circle A moves by -d relative to B, the normal comes out of B
+    if (!toiCirclePoly({A.cx + d.x, A.cy + d.y}, A.radius, mul(d, -1), B, t, n)) return false;
+    n = mul(n, -1);
+    return true;
+}
+
+// === Scene queries ===
+
+// Segment p + d * t against a cached shape, t in [0, 1]. n is the surface normal.
+// Segments starting inside the shape don't hit it
+bool raycastShape(const WorldShape& s, Vec2 p, Vec2 d, float& t, Vec2& n) {
+    if (s.hull) return raycastHull(s, p, d, t, n);
+    if (s.count > 0) return toiCirclePoly(p, 0.0f, d, s, t, n);
+    return toiCircleCircle({s.cx, s.cy}, s.radius, add(p, d), 0.0f, d, t, n);
+}
+
+bool shapesOverlap(const WorldShape& A, const WorldShape& B) {
+    Vec2 mtv;
+    if (A.hull || B.hull) return gjkShapeShape(A, B, mtv);
+    if (A.count > 0 && B.count > 0) return satShapeShape(A, B, mtv);
+    if (A.count > 0) return satCircleShape({B.cx, B.cy}, B.radius, A, mtv);
+    if (B.count > 0) return satCircleShape({A.cx, A.cy}, A.radius, B, mtv);
+    return satCircleCircle({A.cx, A.cy}, A.radius, {B.cx, B.cy}, B.radius, mtv);
+}
@@ -0,0 +1,402 @@
+//
+//  physics_simd.cpp rbashkort 16/10/2026
+//
+
+#include "physics_simd.h"
+
+// The scalar kernels must round like the vector ones: no contraction of
+// a * b + c into an FMA when the build targets a CPU with it (-march=native)
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define RB_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define RB_X86_SIMD 0
+#endif
+
+namespace {
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+SimdLevel detectSimdLevel() {
+#if RB_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    return SimdLevel::SSE2; // baseline whenever the compiler targets SSE2
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const SimdLevel supportedLevel = detectSimdLevel();
+SimdLevel simdLevel = supportedLevel;
+
+// The vector loops run over whole registers, so the tail lanes are zeroed
+// instead of reading garbage. Results of these lanes are ignored.
+void padLanes(ShapeBatch& b, uint32_t width) {
+    uint32_t end = (b.count + width - 1) / width * width;
+    if (end > SHAPE_BATCH_SIZE) end = SHAPE_BATCH_SIZE;
+    for (uint32_t i = b.count; i < end; ++i) {
+        b.ax[i] = b.ay[i] = b.aw[i] = b.ah[i] = 0.0f;
+        b.bx[i] = b.by[i] = b.bw[i] = b.bh[i] = 0.0f;
+    }
+}
+
+// ---------------------------------------------------------------- scalar
+
+void circleCircleScalar(ShapeBatch& b, uint32_t begin) {
+    for (uint32_t i = begin; i < b.count; ++i) {
+        float dx = b.bx[i] - b.ax[i];
+        float dy = b.by[i] - b.ay[i];
+        float rs = b.aw[i] + b.bw[i];
+        float d2 = dx * dx + dy * dy;
+        b.hit[i] = d2 < rs * rs;
+        if (!b.hit[i]) continue;
+
+        float dist = std::sqrt(d2);
+        if (dist > 1e-6f) {
+            float s = (rs - dist) / dist;
+            b.mtvX[i] = dx * s;
+            b.mtvY[i] = dy * s;
+        } else {
+            b.mtvX[i] = rs;
+            b.mtvY[i] = 0.0f;
+        }
+    }
+}
+
+void boxBoxScalar(ShapeBatch& b, uint32_t begin) {
+    for (uint32_t i = begin; i < b.count; ++i) {
+        float dx = b.bx[i] - b.ax[i];
+        float dy = b.by[i] - b.ay[i];
+        float ox = b.aw[i] + b.bw[i] - std::fabs(dx);
+        float oy = b.ah[i] + b.bh[i] - std::fabs(dy);
+        b.hit[i] = ox >= 0.0f && oy >= 0.0f;
+        if (!b.hit[i]) continue;
+
+        // same axis order as satPolyPoly: y wins ties
+        if (ox < oy) {
+            b.mtvX[i] = dx < 0.0f ? -ox : ox;
+            b.mtvY[i] = 0.0f;
+        } else {
+            b.mtvX[i] = 0.0f;
+            b.mtvY[i] = dy < 0.0f ? -oy : oy;
+        }
+    }
+}
+
+void integrateScalar(BodyStore& s, float dt, uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+        s.x[i] += s.vx[i] * dt * s.moveScale[i];
+        s.y[i] += s.vy[i] * dt * s.moveScale[i];
+        s.vy[i] += s.gravity[i] * dt;
+    }
+}
+
+void circleBoxScalar(ShapeBatch& b, uint32_t begin) {
+    for (uint32_t i = begin; i < b.count; ++i) {
+        float cx = b.ax[i], cy = b.ay[i], r = b.aw[i];
+        float dx = b.bx[i] - cx;
+        float dy = b.by[i] - cy;
+
+        // closest point of the box to the circle center, relative to the center
+        float qx = std::fmin(std::fmax(dx - b.bw[i], 0.0f), dx + b.bw[i]);
+        float qy = std::fmin(std::fmax(dy - b.bh[i], 0.0f), dy + b.bh[i]);
+        float d2 = qx * qx + qy * qy;
+        b.hit[i] = d2 <= r * r;
+        if (!b.hit[i]) continue;
+
+        if (d2 > 1e-12f) {
+            float dist = std::sqrt(d2);
+            float s = (r - dist) / dist;
+            b.mtvX[i] = qx * s;
+            b.mtvY[i] = qy * s;
+        } else {
+            // center inside the box: push out along the shallow axis
+            float px = b.bw[i] - std::fabs(dx) + r;
+            float py = b.bh[i] - std::fabs(dy) + r;
+            if (px < py) {
+                b.mtvX[i] = dx < 0.0f ? -px : px;
+                b.mtvY[i] = 0.0f;
+            } else {
+                b.mtvX[i] = 0.0f;
+                b.mtvY[i] = dy < 0.0f ? -py : py;
+            }
+        }
+    }
+}
+
+#if RB_X86_SIMD
+
+// ---------------------------------------------------------------- SSE2
+
+inline __m128 absPs(__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+// copies the sign of s onto the positive value v (s == 0 counts as positive)
+inline __m128 signPs(__m128 v, __m128 s) {
+    __m128 neg = _mm_cmplt_ps(s, _mm_setzero_ps());
+    return _mm_or_ps(v, _mm_and_ps(neg, _mm_set1_ps(-0.0f)));
+}
+inline __m128 selectPs(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+inline void storeHits(uint8_t* hit, int mask, int lanes) {
+    for (int l = 0; l < lanes; ++l) hit[l] = (mask >> l) & 1;
+}
+
+void circleCircleSSE(ShapeBatch& b) {
+    const __m128 eps = _mm_set1_ps(1e-6f);
+    for (uint32_t i = 0; i < b.count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(b.bx + i), _mm_load_ps(b.ax + i));
+        __m128 dy = _mm_sub_ps(_mm_load_ps(b.by + i), _mm_load_ps(b.ay + i));
+        __m128 rs = _mm_add_ps(_mm_load_ps(b.aw + i), _mm_load_ps(b.bw + i));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 hit = _mm_cmplt_ps(d2, _mm_mul_ps(rs, rs));
+        int mask = _mm_movemask_ps(hit);
+        storeHits(b.hit + i, mask, 4);
+        if (!mask) continue;
+
+        __m128 dist = _mm_sqrt_ps(d2);
+        __m128 valid = _mm_cmpgt_ps(dist, eps);
+        __m128 s = _mm_div_ps(_mm_sub_ps(rs, dist), _mm_max_ps(dist, eps));
+        _mm_store_ps(b.mtvX + i, selectPs(valid, _mm_mul_ps(dx, s), rs));
+        _mm_store_ps(b.mtvY + i, _mm_and_ps(valid, _mm_mul_ps(dy, s)));
+    }
+}
+
+void boxBoxSSE(ShapeBatch& b) {
+    const __m128 zero = _mm_setzero_ps();
+    for (uint32_t i = 0; i < b.count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(b.bx + i), _mm_load_ps(b.ax + i));
+        __m128 dy = _mm_sub_ps(_mm_load_ps(b.by + i), _mm_load_ps(b.ay + i));
+        __m128 ox = _mm_sub_ps(_mm_add_ps(_mm_load_ps(b.aw + i), _mm_load_ps(b.bw + i)), absPs(dx));
+        __m128 oy = _mm_sub_ps(_mm_add_ps(_mm_load_ps(b.ah + i), _mm_load_ps(b.bh + i)), absPs(dy));
+        __m128 hit = _mm_and_ps(_mm_cmpge_ps(ox, zero), _mm_cmpge_ps(oy, zero));
+        int mask = _mm_movemask_ps(hit);
+        storeHits(b.hit + i, mask, 4);
+        if (!mask) continue;
+
+        __m128 useX = _mm_cmplt_ps(ox, oy);
+        _mm_store_ps(b.mtvX + i, _mm_and_ps(useX, signPs(ox, dx)));
+        _mm_store_ps(b.mtvY + i, _mm_andnot_ps(useX, signPs(oy, dy)));
+    }
+}
+
+void circleBoxSSE(ShapeBatch& b) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 eps = _mm_set1_ps(1e-12f);
+    for (uint32_t i = 0; i < b.count; i += 4) {
+        __m128 r = _mm_load_ps(b.aw + i);
+        __m128 hw = _mm_load_ps(b.bw + i);
+        __m128 hh = _mm_load_ps(b.bh + i);
+        __m128 dx = _mm_sub_ps(_mm_load_ps(b.bx + i), _mm_load_ps(b.ax + i));
+        __m128 dy = _mm_sub_ps(_mm_load_ps(b.by + i), _mm_load_ps(b.ay + i));
+        __m128 qx = _mm_min_ps(_mm_max_ps(_mm_sub_ps(dx, hw), zero), _mm_add_ps(dx, hw));
+        __m128 qy = _mm_min_ps(_mm_max_ps(_mm_sub_ps(dy, hh), zero), _mm_add_ps(dy, hh));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy));
+        __m128 hit = _mm_cmple_ps(d2, _mm_mul_ps(r, r));
+        int mask = _mm_movemask_ps(hit);
+        storeHits(b.hit + i, mask, 4);
+        if (!mask) continue;
+
+        // outside: along the closest point
+        __m128 dist = _mm_sqrt_ps(_mm_max_ps(d2, eps));
+        __m128 s = _mm_div_ps(_mm_sub_ps(r, dist), dist);
+        __m128 outX = _mm_mul_ps(qx, s);
+        __m128 outY = _mm_mul_ps(qy, s);
+
+        // inside: along the shallow axis
+        __m128 px = _mm_add_ps(_mm_sub_ps(hw, absPs(dx)), r);
+        __m128 py = _mm_add_ps(_mm_sub_ps(hh, absPs(dy)), r);
+        __m128 useX = _mm_cmplt_ps(px, py);
+        __m128 inX = _mm_and_ps(useX, signPs(px, dx));
+        __m128 inY = _mm_andnot_ps(useX, signPs(py, dy));
+
+        __m128 outside = _mm_cmpgt_ps(d2, eps);
+        _mm_store_ps(b.mtvX + i, selectPs(outside, outX, inX));
+        _mm_store_ps(b.mtvY + i, selectPs(outside, outY, inY));
+    }
+}
+
+// BodyStore columns are plain vectors: unaligned loads, scalar tail
+uint32_t integrateSSE(BodyStore& s, float dt, uint32_t begin, uint32_t end) {
+    const __m128 vdt = _mm_set1_ps(dt);
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 scale = _mm_loadu_ps(s.moveScale.data() + i);
+        __m128 vy = _mm_loadu_ps(s.vy.data() + i);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(s.x.data() + i),
+                              _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(s.vx.data() + i), vdt), scale));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(s.y.data() + i), _mm_mul_ps(_mm_mul_ps(vy, vdt), scale));
+        vy = _mm_add_ps(vy, _mm_mul_ps(_mm_loadu_ps(s.gravity.data() + i), vdt));
+        _mm_storeu_ps(s.x.data() + i, x);
+        _mm_storeu_ps(s.y.data() + i, y);
+        _mm_storeu_ps(s.vy.data() + i, vy);
+    }
+    return i;
+}
+
+// ---------------------------------------------------------------- AVX2
+
+// No FMA: a fused multiply-add rounds once, so d2 would differ from the
+// SSE2/scalar result in the last bit and flip hits right at the threshold
+#define RB_AVX2 __attribute__((target("avx2")))
+
+RB_AVX2 inline __m256 absPs8(__m256 v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+RB_AVX2 inline __m256 signPs8(__m256 v, __m256 s) {
+    __m256 neg = _mm256_cmp_ps(s, _mm256_setzero_ps(), _CMP_LT_OQ);
+    return _mm256_or_ps(v, _mm256_and_ps(neg, _mm256_set1_ps(-0.0f)));
+}
+
+RB_AVX2 void circleCircleAVX2(ShapeBatch& b) {
+    const __m256 eps = _mm256_set1_ps(1e-6f);
+    for (uint32_t i = 0; i < b.count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_load_ps(b.bx + i), _mm256_load_ps(b.ax + i));
+        __m256 dy = _mm256_sub_ps(_mm256_load_ps(b.by + i), _mm256_load_ps(b.ay + i));
+        __m256 rs = _mm256_add_ps(_mm256_load_ps(b.aw + i), _mm256_load_ps(b.bw + i));
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 hit = _mm256_cmp_ps(d2, _mm256_mul_ps(rs, rs), _CMP_LT_OQ);
+        int mask = _mm256_movemask_ps(hit);
+        storeHits(b.hit + i, mask, 8);
+        if (!mask) continue;
+
+        __m256 dist = _mm256_sqrt_ps(d2);
+        __m256 valid = _mm256_cmp_ps(dist, eps, _CMP_GT_OQ);
+        __m256 s = _mm256_div_ps(_mm256_sub_ps(rs, dist), _mm256_max_ps(dist, eps));
+        _mm256_store_ps(b.mtvX + i, _mm256_blendv_ps(rs, _mm256_mul_ps(dx, s), valid));
+        _mm256_store_ps(b.mtvY + i, _mm256_and_ps(valid, _mm256_mul_ps(dy, s)));
+    }
+}
+
+RB_AVX2 void boxBoxAVX2(ShapeBatch& b) {
+    const __m256 zero = _mm256_setzero_ps();
+    for (uint32_t i = 0; i < b.count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_load_ps(b.bx + i), _mm256_load_ps(b.ax + i));
+        __m256 dy = _mm256_sub_ps(_mm256_load_ps(b.by + i), _mm256_load_ps(b.ay + i));
+        __m256 ox = _mm256_sub_ps(_mm256_add_ps(_mm256_load_ps(b.aw + i), _mm256_load_ps(b.bw + i)), absPs8(dx));
+        __m256 oy = _mm256_sub_ps(_mm256_add_ps(_mm256_load_ps(b.ah + i), _mm256_load_ps(b.bh + i)), absPs8(dy));
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(ox, zero, _CMP_GE_OQ), _mm256_cmp_ps(oy, zero, _CMP_GE_OQ));
+        int mask = _mm256_movemask_ps(hit);
+        storeHits(b.hit + i, mask, 8);
+        if (!mask) continue;
+
+        __m256 useX = _mm256_cmp_ps(ox, oy, _CMP_LT_OQ);
+        _mm256_store_ps(b.mtvX + i, _mm256_and_ps(useX, signPs8(ox, dx)));
+        _mm256_store_ps(b.mtvY + i, _mm256_andnot_ps(useX, signPs8(oy, dy)));
+    }
+}
+
+RB_AVX2 void circleBoxAVX2(ShapeBatch& b) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eps = _mm256_set1_ps(1e-12f);
+    for (uint32_t i = 0; i < b.count; i += 8) {
+        __m256 r = _mm256_load_ps(b.aw + i);
+        __m256 hw = _mm256_load_ps(b.bw + i);
+        __m256 hh = _mm256_load_ps(b.bh + i);
+        __m256 dx = _mm256_sub_ps(_mm256_load_ps(b.bx + i), _mm256_load_ps(b.ax + i));
+        __m256 dy = _mm256_sub_ps(_mm256_load_ps(b.by + i), _mm256_load_ps(b.ay + i));
+        __m256 qx = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(dx, hw), zero), _mm256_add_ps(dx, hw));
+        __m256 qy = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(dy, hh), zero), _mm256_add_ps(dy, hh));
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy));
+        __m256 hit = _mm256_cmp_ps(d2, _mm256_mul_ps(r, r), _CMP_LE_OQ);
+        int mask = _mm256_movemask_ps(hit);
+        storeHits(b.hit + i, mask, 8);
+        if (!mask) continue;
+
+        __m256 dist = _mm256_sqrt_ps(_mm256_max_ps(d2, eps));
+        __m256 s = _mm256_div_ps(_mm256_sub_ps(r, dist), dist);
+        __m256 outX = _mm256_mul_ps(qx, s);
+        __m256 outY = _mm256_mul_ps(qy, s);
+
+        __m256 px = _mm256_add_ps(_mm256_sub_ps(hw, absPs8(dx)), r);
+        __m256 py = _mm256_add_ps(_mm256_sub_ps(hh, absPs8(dy)), r);
+        __m256 useX = _mm256_cmp_ps(px, py, _CMP_LT_OQ);
+        __m256 inX = _mm256_and_ps(useX, signPs8(px, dx));
+        __m256 inY = _mm256_andnot_ps(useX, signPs8(py, dy));
+
+        __m256 outside = _mm256_cmp_ps(d2, eps, _CMP_GT_OQ);
+        _mm256_store_ps(b.mtvX + i, _mm256_blendv_ps(inX, outX, outside));
+        _mm256_store_ps(b.mtvY + i, _mm256_blendv_ps(inY, outY, outside));
+    }
+}
+
+RB_AVX2 uint32_t integrateAVX2(BodyStore& s, float dt, uint32_t begin, uint32_t end) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 scale = _mm256_loadu_ps(s.moveScale.data() + i);
+        __m256 vy = _mm256_loadu_ps(s.vy.data() + i);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(s.x.data() + i),
+                                 _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(s.vx.data() + i), vdt), scale));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(s.y.data() + i), _mm256_mul_ps(_mm256_mul_ps(vy, vdt), scale));
+        vy = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_loadu_ps(s.gravity.data() + i), vdt));
+        _mm256_storeu_ps(s.x.data() + i, x);
+        _mm256_storeu_ps(s.y.data() + i, y);
+        _mm256_storeu_ps(s.vy.data() + i, vy);
+    }
+    return i;
+}
+
+#undef RB_AVX2
+
+#endif // RB_X86_SIMD
+
+} // namespace
+
+void batchCircleCircle(ShapeBatch& batch) {
+#if RB_X86_SIMD
+    if (simdLevel == SimdLevel::AVX2) { padLanes(batch, 8); circleCircleAVX2(batch); return; }
+    if (simdLevel == SimdLevel::SSE2) { padLanes(batch, 4); circleCircleSSE(batch); return; }
+#endif
+    circleCircleScalar(batch, 0);
+}
+
+void batchBoxBox(ShapeBatch& batch) {
+#if RB_X86_SIMD
+    if (simdLevel == SimdLevel::AVX2) { padLanes(batch, 8); boxBoxAVX2(batch); return; }
+    if (simdLevel == SimdLevel::SSE2) { padLanes(batch, 4); boxBoxSSE(batch); return; }
+#endif
+    boxBoxScalar(batch, 0);
+}
+
+void batchCircleBox(ShapeBatch& batch) {
+#if RB_X86_SIMD
+    if (simdLevel == SimdLevel::AVX2) { padLanes(batch, 8); circleBoxAVX2(batch); return; }
+    if (simdLevel == SimdLevel::SSE2) { padLanes(batch, 4); circleBoxSSE(batch); return; }
+#endif
+    circleBoxScalar(batch, 0);
+}
+
+void integrateBodies(BodyStore& store, float dt, uint32_t begin, uint32_t end) {
+#if RB_X86_SIMD
+    if (simdLevel == SimdLevel::AVX2) begin = integrateAVX2(store, dt, begin, end);
+    else if (simdLevel == SimdLevel::SSE2) begin = integrateSSE(store, dt, begin, end);
+#endif
+    integrateScalar(store, dt, begin, end);
+}
+
+const char* simdLevelName() {
+    switch (simdLevel) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+bool setSimdLevel(const char* name) {
+    SimdLevel level;
+    if (std::strcmp(name, "avx2") == 0) level = SimdLevel::AVX2;
+    else if (std::strcmp(name, "sse2") == 0) level = SimdLevel::SSE2;
+    else if (std::strcmp(name, "scalar") == 0) level = SimdLevel::Scalar;
+    else return false;
+    if (level > supportedLevel) return false;
+    simdLevel = level;
+    return true;
+}
@@ -0,0 +1,81 @@
+//
+//  physics_simd.h rbashkort 16/10/2026
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Batched narrowphase kernels. Pairs of one shape-pair type are collected in
+// a ShapeBatch (structure of arrays) and tested 8 (AVX2) or 4 (SSE2) lanes at
+// a time. The instruction set is picked at runtime, scalar code is used on
+// other CPUs.
+//
+// Shapes are described by center + size:
+//   circle:             w = radius
+//   axis-aligned rect:  w, h = half extents
+// The kernels write hit[i] and the MTV that pushes B out of A. Every
+// instruction set gives bit-identical results (no FMA, same operation order).
+
+constexpr uint32_t SHAPE_BATCH_SIZE = 256;
+
+struct alignas(32) ShapeBatch {
+    float ax[SHAPE_BATCH_SIZE], ay[SHAPE_BATCH_SIZE], aw[SHAPE_BATCH_SIZE], ah[SHAPE_BATCH_SIZE];
+    float bx[SHAPE_BATCH_SIZE], by[SHAPE_BATCH_SIZE], bw[SHAPE_BATCH_SIZE], bh[SHAPE_BATCH_SIZE];
+    float mtvX[SHAPE_BATCH_SIZE], mtvY[SHAPE_BATCH_SIZE];
+    uint8_t hit[SHAPE_BATCH_SIZE];
+
+    // caller data per lane (body indices, flags), untouched by the kernels
+    uint32_t bodyA[SHAPE_BATCH_SIZE], bodyB[SHAPE_BATCH_SIZE];
+    uint8_t flags[SHAPE_BATCH_SIZE];
+
+    uint32_t count = 0;
+
+    bool full() const { return count == SHAPE_BATCH_SIZE; }
+    void clear() { count = 0; }
+
+    uint32_t push(float axv, float ayv, float awv, float ahv,
+                  float bxv, float byv, float bwv, float bhv) {
+        uint32_t i = count++;
+        ax[i] = axv; ay[i] = ayv; aw[i] = awv; ah[i] = ahv;
+        bx[i] = bxv; by[i] = byv; bw[i] = bwv; bh[i] = bhv;
+        return i;
+    }
+};
+
+// circle A vs circle B
+void batchCircleCircle(ShapeBatch& batch);
+// axis-aligned rect A vs axis-aligned rect B
+void batchBoxBox(ShapeBatch& batch);
+// circle A vs axis-aligned rect B
+void batchCircleBox(ShapeBatch& batch);
+
+// Moving bodies as structure of arrays for the integrator. ECSWorld copies
+// E_Transform/E_Velocity/E_Gravity in before a step and x, y, vx, vy back
+// after it. Buffers keep their capacity between steps.
+struct BodyStore {
+    std::vector<float> x, y;
+    std::vector<float> vx, vy;
+    std::vector<float> gravity;    // E_Gravity::a, 0 without gravity or when frozen
+    std::vector<float> moveScale;  // 0 for frozen bodies (E_Velocity::freeze), else 1
+    uint32_t count = 0;
+
+    void resize(uint32_t n) {
+        count = n;
+        x.resize(n); y.resize(n);
+        vx.resize(n); vy.resize(n);
+        gravity.resize(n); moveScale.resize(n);
+    }
+};
+
+// Explicit Euler step of bodies [begin, end): position with the old velocity,
+// then gravity into vy. Same result on every instruction set (no FMA)
+void integrateBodies(BodyStore& store, float dt, uint32_t begin, uint32_t end);
+
+// "avx2", "sse2" or "scalar"
+const char* simdLevelName();
+
+// Forces the instruction set by name (tests, benchmarks). False for an unknown
+// name or one the CPU does not support. Not thread-safe: call it between steps
+bool setSimdLevel(const char* name);
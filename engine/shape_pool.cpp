@@ -0,0 +1,87 @@
+//
+//  shape_pool.cpp rbashkort 16/10/2026
+//
+
+#include "shape_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Point { float x, y; };
+
+float cross(Point o, Point a, Point b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// deque: ids stay valid while new polygons are added
+std::deque<ConvexPolygon>& pool() {
+    static std::deque<ConvexPolygon> polygons(1); // id 0 = empty
+    return polygons;
+}
+
+std::mutex poolMutex;
+
+} // namespace
+
+uint32_t createPolygon(const float* xy, int count) {
+    // monotone chain, collinear points dropped
+    std::vector<Point> points(count);
+    for (int i = 0; i < count; ++i) points[i] = {xy[2 * i], xy[2 * i + 1]};
+    std::sort(points.begin(), points.end(), [](Point a, Point b) {
+        return a.x != b.x ? a.x < b.x : a.y < b.y;
+    });
+
+    std::vector<Point> hull(2 * points.size());
+    int k = 0;
+    for (int i = 0; i < count; ++i) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0f) --k;
+        hull[k++] = points[i];
+    }
+    for (int i = count - 2, lower = k + 1; i >= 0; --i) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0f) --k;
+        hull[k++] = points[i];
+    }
+    int n = k > 0 ? k - 1 : 0; // last point repeats the first
+
+    if (n < 3 || n > MAX_POLYGON_VERTICES) {
+        printf("[Engine] createPolygon: hull has %d vertices, expected 3..%d\n", n, MAX_POLYGON_VERTICES);
+        return 0;
+    }
+
+    ConvexPolygon poly;
+    poly.count = n;
+    float area = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        Point a = hull[i], b = hull[(i + 1) % n];
+        poly.x[i] = a.x;
+        poly.y[i] = a.y;
+
+        float ex = b.x - a.x, ey = b.y - a.y;
+        float len = std::sqrt(ex * ex + ey * ey);
+        poly.nx[i] = ey / len; // counter-clockwise -> right side is outside
+        poly.ny[i] = -ex / len;
+
+        float w = a.x * b.y - b.x * a.y;
+        area += w;
+        poly.cx += (a.x + b.x) * w;
+        poly.cy += (a.y + b.y) * w;
+        poly.radius = std::max(poly.radius, std::sqrt(a.x * a.x + a.y * a.y));
+    }
+    poly.cx /= 3.0f * area;
+    poly.cy /= 3.0f * area;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    pool().push_back(poly);
+    return (uint32_t)pool().size() - 1;
+}
+
+const ConvexPolygon& getPolygon(uint32_t id) {
+    const std::deque<ConvexPolygon>& polygons = pool();
+    return id < polygons.size() ? polygons[id] : polygons[0];
+}
@@ -0,0 +1,31 @@
+//
+//  shape_pool.h rbashkort 16/10/2026
+//
+
+#pragma once
+
+#include <cstdint>
+
+// Convex polygon colliders (ColliderType::Polygon). The vertices live once in
+// a shared pool, colliders only keep the id (E_Collider::polygon), so a
+// thousand identical rocks cost one polygon.
+constexpr int MAX_POLYGON_VERTICES = 16;
+
+struct ConvexPolygon {
+    int count = 0;
+    // local space (relative to transform + collider offset), counter-clockwise
+    float x[MAX_POLYGON_VERTICES], y[MAX_POLYGON_VERTICES];
+    // outward unit normal of edge i -> i+1
+    float nx[MAX_POLYGON_VERTICES], ny[MAX_POLYGON_VERTICES];
+    float cx = 0.0f, cy = 0.0f;  // centroid
+    float radius = 0.0f;         // farthest vertex from the local origin
+};
+
+// Stores the convex hull of the points (xy = x0, y0, x1, y1, ...) and returns
+// its id for E_Collider::polygon, 0 if the hull is degenerate or has more than
+// MAX_POLYGON_VERTICES vertices. Create polygons outside ECSWorld::update(),
+// the physics threads read the pool without locking
+uint32_t createPolygon(const float* xy, int count);
+
+// Polygon of the id. Id 0 (or an unknown id) gives an empty polygon
+const ConvexPolygon& getPolygon(uint32_t id);
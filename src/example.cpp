@@ -101,6 +101,8 @@ int main() {
 
             ImGui::End();
 
+            gui.physicsStats(eng.getECS());
+
             gui.end();
         }
     };
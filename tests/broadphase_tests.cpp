@@ -0,0 +1,238 @@
+//
+//  broadphase_tests.cpp rbashkort 16/10/2026
+//
+//  Broadphase structures against brute force: every overlapping pair is
+//  reported exactly once, nothing else is. Random but seeded data over several
+//  frames, so proxies move, appear and disappear like colliders do.
+//
+
+#include "test_common.h"
+#include "broadphase.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+using PairList = std::vector<std::pair<uint32_t, uint32_t>>;
+
+// One frame of colliders: entity id, box. Payload = index in the frame
+struct Frame {
+    std::vector<flecs::entity_t> ids;
+    std::vector<Aabb> boxes;
+};
+
+// n colliders over a square of the given size, a few of them huge (level walls)
+static Frame randomFrame(std::mt19937& rng, uint32_t n, float extent) {
+    std::uniform_real_distribution<float> pos(-extent * 0.5f, extent * 0.5f), size(1.0f, 30.0f);
+    Frame f;
+    for (uint32_t i = 0; i < n; ++i) {
+        float x = pos(rng), y = pos(rng);
+        float w = size(rng), h = size(rng);
+        if (i % 97 == 0) w *= 40.0f;
+        f.ids.push_back(i + 1);
+        f.boxes.push_back({x - w, y - h, x + w, y + h});
+    }
+    return f;
+}
+
+// Next frame: every box moves a bit, some colliders are removed and new ones added
+static void stepFrame(std::mt19937& rng, Frame& f, flecs::entity_t& nextId, float extent) {
+    std::uniform_real_distribution<float> step(-6.0f, 6.0f), pos(-extent * 0.5f, extent * 0.5f);
+    Frame next;
+    for (size_t i = 0; i < f.ids.size(); ++i) {
+        if (rng() % 20 == 0) continue; // removed
+        float dx = step(rng), dy = step(rng);
+        const Aabb& b = f.boxes[i];
+        next.ids.push_back(f.ids[i]);
+        next.boxes.push_back({b.minX + dx, b.minY + dy, b.maxX + dx, b.maxY + dy});
+    }
+    for (int k = 0; k < 30; ++k) {
+        float x = pos(rng), y = pos(rng);
+        next.ids.push_back(nextId++);
+        next.boxes.push_back({x - 8.0f, y - 8.0f, x + 8.0f, y + 8.0f});
+    }
+    f = next;
+}
+
+static PairList bruteForcePairs(const std::vector<Aabb>& boxes, float grow = 0.0f) {
+    PairList pairs;
+    for (uint32_t i = 0; i < (uint32_t)boxes.size(); ++i)
+    for (uint32_t j = i + 1; j < (uint32_t)boxes.size(); ++j) {
+        Aabb a = boxes[i];
+        a = {a.minX - grow, a.minY - grow, a.maxX + grow, a.maxY + grow};
+        if (a.overlaps(boxes[j])) pairs.push_back({i, j});
+    }
+    return pairs;
+}
+
+// Sorts (a, b) into (min, max) order, checks for duplicates
+static void normalize(PairList& pairs) {
+    for (auto& p : pairs) {
+        if (p.first > p.second) std::swap(p.first, p.second);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    auto dup = std::adjacent_find(pairs.begin(), pairs.end());
+    CHECK_MSG(dup == pairs.end(), "pair (%u, %u) reported twice", dup->first, dup->second);
+}
+
+// ================= Sweep and prune =================
+
+static void testSweepAndPrunePairs() {
+    std::mt19937 rng(1);
+    const float extent = 2000.0f;
+    Frame f = randomFrame(rng, 1500, extent);
+    flecs::entity_t nextId = 100000;
+
+    SweepAndPrune sap;
+    for (int frame = 0; frame < 20; ++frame) {
+        sap.beginFrame();
+        for (uint32_t i = 0; i < (uint32_t)f.ids.size(); ++i) sap.update(f.ids[i], f.boxes[i], i);
+        sap.endFrame();
+        CHECK(sap.proxyCount() == f.ids.size());
+
+        PairList found;
+        sap.findPairs([&](uint32_t a, uint32_t b) { found.push_back({a, b}); });
+        normalize(found);
+        PairList expected = bruteForcePairs(f.boxes);
+        CHECK_MSG(found == expected, "frame %d: %zu pairs, brute force %zu", frame, found.size(), expected.size());
+
+        stepFrame(rng, f, nextId, extent);
+
+        // mass spawn: as many new proxies as there are old ones, merged in one frame
+        if (frame == 9) {
+            Frame spawn = randomFrame(rng, (uint32_t)f.ids.size(), extent);
+            for (size_t i = 0; i < spawn.ids.size(); ++i) {
+                f.ids.push_back(nextId++);
+                f.boxes.push_back(spawn.boxes[i]);
+            }
+        }
+    }
+
+    sap.clear();
+    CHECK(sap.proxyCount() == 0);
+}
+
+// Box queries report exactly the overlapping boxes, also after the order was
+// repaired over a few frames and with the world-wide boxes of randomFrame
+static void testSweepAndPruneQueries() {
+    std::mt19937 rng(4);
+    const float extent = 2000.0f;
+    Frame f = randomFrame(rng, 1500, extent);
+    flecs::entity_t nextId = 100000;
+
+    SweepAndPrune sap;
+    std::uniform_real_distribution<float> pos(-extent * 0.6f, extent * 0.6f), size(0.0f, 300.0f);
+    for (int frame = 0; frame < 5; ++frame) {
+        sap.beginFrame();
+        for (uint32_t i = 0; i < (uint32_t)f.ids.size(); ++i) sap.update(f.ids[i], f.boxes[i], i);
+        sap.endFrame();
+
+        for (int q = 0; q < 200; ++q) {
+            const float x = pos(rng), y = pos(rng);
+            const Aabb box = {x, y, x + size(rng), y + size(rng)};
+            std::vector<uint32_t> found, expected;
+            sap.query(box, [&](uint32_t payload) { found.push_back(payload); });
+            std::sort(found.begin(), found.end());
+            for (uint32_t i = 0; i < (uint32_t)f.boxes.size(); ++i) {
+                if (f.boxes[i].overlaps(box)) expected.push_back(i);
+            }
+            CHECK_MSG(found == expected, "frame %d query %d: %zu boxes, brute force %zu",
+                      frame, q, found.size(), expected.size());
+        }
+        stepFrame(rng, f, nextId, extent);
+    }
+}
+
+// ================= AABB tree =================
+
+// Leaves keep fat boxes: pairs and queries may report a little more than the
+// real overlaps, never less. Boxes in these frames only move, so a fat box
+// stays inside its real box grown by 2 * FAT_MARGIN
+static void testAabbTreePairs() {
+    std::mt19937 rng(2);
+    const float extent = 2000.0f;
+    const float slack = 4.0f * AabbTree::FAT_MARGIN; // both fat boxes of a pair
+    Frame f = randomFrame(rng, 1500, extent);
+    flecs::entity_t nextId = 100000;
+
+    AabbTree tree;
+    for (int frame = 0; frame < 20; ++frame) {
+        tree.beginFrame();
+        for (uint32_t i = 0; i < (uint32_t)f.ids.size(); ++i) tree.update(f.ids[i], f.boxes[i], i);
+        tree.endFrame();
+        CHECK(tree.proxyCount() == f.ids.size());
+        CHECK_MSG(tree.height() <= 2 * (int)std::log2((double)f.ids.size()) + 2, "height %d", tree.height());
+
+        PairList found;
+        tree.findPairs([&](uint32_t a, uint32_t b) { found.push_back({a, b}); });
+        normalize(found);
+
+        PairList real = bruteForcePairs(f.boxes);
+        CHECK_MSG(std::includes(found.begin(), found.end(), real.begin(), real.end()),
+                  "frame %d: a real overlap is missing", frame);
+        PairList loose = bruteForcePairs(f.boxes, slack);
+        CHECK_MSG(std::includes(loose.begin(), loose.end(), found.begin(), found.end()),
+                  "frame %d: a pair farther apart than the fat margin", frame);
+
+        if (frame < 19) stepFrame(rng, f, nextId, extent);
+    }
+
+    // a removed leaf is gone from every query
+    tree.remove(f.ids[0]);
+    CHECK(tree.proxyCount() == f.ids.size() - 1);
+    bool seen = false;
+    tree.query(f.boxes[0], [&](uint32_t payload) { seen |= payload == 0; });
+    CHECK(!seen);
+}
+
+static void testAabbTreeQueries() {
+    std::mt19937 rng(3);
+    const float extent = 2000.0f;
+    Frame f = randomFrame(rng, 2000, extent);
+
+    AabbTree tree;
+    tree.beginFrame();
+    for (uint32_t i = 0; i < (uint32_t)f.ids.size(); ++i) tree.update(f.ids[i], f.boxes[i], i);
+    tree.endFrame();
+
+    std::uniform_real_distribution<float> pos(-extent * 0.5f, extent * 0.5f), size(0.0f, 200.0f);
+    for (int q = 0; q < 500; ++q) {
+        float x = pos(rng), y = pos(rng), w = size(rng), h = size(rng);
+        const Aabb box = {x, y, x + w, y + h};
+        std::vector<uint32_t> found;
+        tree.query(box, [&](uint32_t payload) { found.push_back(payload); });
+        std::sort(found.begin(), found.end());
+        CHECK(std::adjacent_find(found.begin(), found.end()) == found.end());
+        for (uint32_t i = 0; i < (uint32_t)f.boxes.size(); ++i) {
+            if (f.boxes[i].overlaps(box)) {
+                CHECK_MSG(std::binary_search(found.begin(), found.end(), i), "query %d misses box %u", q, i);
+            }
+        }
+
+        // segment: every real box it crosses is visited
+        const float dx = pos(rng) - x, dy = pos(rng) - y;
+        std::vector<uint32_t> crossed;
+        tree.raycast(x, y, dx, dy, 1.0f, [&](uint32_t payload, float maxT) {
+            crossed.push_back(payload);
+            return maxT;
+        });
+        std::sort(crossed.begin(), crossed.end());
+        for (uint32_t i = 0; i < (uint32_t)f.boxes.size(); ++i) {
+            if (f.boxes[i].intersectsSegment(x, y, dx, dy, 1.0f)) {
+                CHECK_MSG(std::binary_search(crossed.begin(), crossed.end(), i), "ray %d misses box %u", q, i);
+            }
+        }
+    }
+}
+
+int main() {
+    const TestCase tests[] = {
+        {"sweep and prune pairs == brute force", testSweepAndPrunePairs},
+        {"sweep and prune box queries == brute force", testSweepAndPruneQueries},
+        {"aabb tree pairs cover brute force within the fat margin", testAabbTreePairs},
+        {"aabb tree box and segment queries", testAabbTreeQueries},
+    };
+    return runTests(tests, sizeof(tests) / sizeof(tests[0]));
+}
@@ -0,0 +1,341 @@
+//
+//  narrowphase_tests.cpp rbashkort 16/10/2026
+//
+//  Narrowphase kernels: the batched SIMD kernels give the same bits on every
+//  instruction set the CPU supports, including pairs right at the hit
+//  threshold where a different rounding flips the result. GJK/EPA against
+//  SAT on the same boxes, time of impact against a sampled sweep.
+//
+
+#include "test_common.h"
+#include "physics.hpp" // function definitions, this is the only TU including it
+#include "physics_simd.h"
+#include "shape_pool.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+static const char* const SIMD_LEVELS[] = {"scalar", "sse2", "avx2"};
+
+static uint32_t floatBits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+// A full batch of pairs, most of them touching or nearly touching: B is put
+// at the contact distance along a random direction, then nudged by a few ulps.
+// Some lanes have coincident centers or B's center inside A
+static ShapeBatch nearContactBatch(std::mt19937& rng, bool aIsBox, bool bIsBox, uint32_t count) {
+    std::uniform_real_distribution<float> pos(-500.0f, 500.0f), size(0.5f, 40.0f), angle(0.0f, 6.2831853f);
+    std::uniform_int_distribution<int> ulps(-3, 3);
+    ShapeBatch b;
+    for (uint32_t i = 0; i < count; ++i) {
+        const float ax = pos(rng), ay = pos(rng);
+        const float aw = size(rng), ah = aIsBox ? size(rng) : aw;
+        const float bw = size(rng), bh = bIsBox ? size(rng) : bw;
+        const float a = angle(rng);
+        float dist = (aIsBox ? std::fmax(aw, ah) : aw) + (bIsBox ? std::fmax(bw, bh) : bw);
+        float bx = ax + std::cos(a) * dist, by = ay + std::sin(a) * dist;
+
+        switch (i % 8) {
+            case 0: bx = ax; by = ay; break;                          // coincident
+            case 1: bx = ax + aw + bw; by = ay; break;                // exact touch on x
+            case 2: bx = ax; by = ay - ah - bh; break;                // exact touch on y
+            case 3: bx = ax + 0.25f * aw; by = ay - 0.25f * ah; break; // deep
+            default: break;
+        }
+        bx = std::nextafter(bx, bx + (float)ulps(rng));
+        by = std::nextafter(by, by + (float)ulps(rng));
+        b.push(ax, ay, aw, ah, bx, by, bw, bh);
+    }
+    return b;
+}
+
+// Runs the kernel on every supported level and compares hit and MTV bits of
+// every lane against the scalar result
+static void checkKernel(const char* name, void (*kernel)(ShapeBatch&), bool aIsBox, bool bIsBox) {
+    std::mt19937 rng(7);
+    for (uint32_t count : {SHAPE_BATCH_SIZE, 253u, 5u}) {
+        const ShapeBatch input = nearContactBatch(rng, aIsBox, bIsBox, count);
+
+        CHECK(setSimdLevel("scalar"));
+        ShapeBatch expected = input;
+        kernel(expected);
+
+        uint32_t hits = 0;
+        for (uint32_t i = 0; i < count; ++i) hits += expected.hit[i];
+        CHECK_MSG(hits > count / 4 && hits < count, "%s: %u of %u lanes hit, data is not near the threshold",
+                  name, hits, count);
+
+        for (const char* level : SIMD_LEVELS) {
+            if (!setSimdLevel(level)) continue; // not on this CPU
+            ShapeBatch got = input;
+            kernel(got);
+            for (uint32_t i = 0; i < count; ++i) {
+                CHECK_MSG(got.hit[i] == expected.hit[i], "%s/%s lane %u: hit %d, scalar %d",
+                          name, level, i, got.hit[i], expected.hit[i]);
+                if (!got.hit[i] || !expected.hit[i]) continue;
+                CHECK_MSG(floatBits(got.mtvX[i]) == floatBits(expected.mtvX[i]) &&
+                          floatBits(got.mtvY[i]) == floatBits(expected.mtvY[i]),
+                          "%s/%s lane %u: mtv (%.9g, %.9g), scalar (%.9g, %.9g)", name, level, i,
+                          got.mtvX[i], got.mtvY[i], expected.mtvX[i], expected.mtvY[i]);
+            }
+        }
+    }
+}
+
+// ================= SIMD kernels =================
+
+static void testCircleCircleLevels() { checkKernel("circle-circle", batchCircleCircle, false, false); }
+static void testBoxBoxLevels() { checkKernel("box-box", batchBoxBox, true, true); }
+static void testCircleBoxLevels() { checkKernel("circle-box", batchCircleBox, false, true); }
+
+static void testIntegrateLevels() {
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<float> pos(-1e4f, 1e4f), vel(-900.0f, 900.0f), g(0.0f, 2000.0f);
+    BodyStore input;
+    input.resize(1003); // vector loops plus a scalar tail
+    for (uint32_t i = 0; i < input.count; ++i) {
+        input.x[i] = pos(rng);
+        input.y[i] = pos(rng);
+        input.vx[i] = vel(rng);
+        input.vy[i] = vel(rng);
+        input.gravity[i] = i % 3 ? g(rng) : 0.0f;
+        input.moveScale[i] = i % 7 ? 1.0f : 0.0f;
+    }
+    const float dt = 1.0f / 60.0f;
+
+    CHECK(setSimdLevel("scalar"));
+    BodyStore expected = input;
+    for (int s = 0; s < 10; ++s) integrateBodies(expected, dt, 0, expected.count);
+
+    for (const char* level : SIMD_LEVELS) {
+        if (!setSimdLevel(level)) continue;
+        BodyStore got = input;
+        for (int s = 0; s < 10; ++s) integrateBodies(got, dt, 0, got.count);
+        for (uint32_t i = 0; i < got.count; ++i) {
+            CHECK_MSG(floatBits(got.x[i]) == floatBits(expected.x[i]) &&
+                      floatBits(got.y[i]) == floatBits(expected.y[i]) &&
+                      floatBits(got.vy[i]) == floatBits(expected.vy[i]),
+                      "%s body %u differs from scalar", level, i);
+        }
+    }
+}
+
+// ================= GJK / EPA =================
+
+// Rect collider and the same rect as a pool polygon, for SAT and GJK
+static void rectAndHull(float w, float h, const E_Transform& t, WorldShape& rect, WorldShape& hull) {
+    E_Collider c;
+    c.type = ColliderType::Rect;
+    c.width = w;
+    c.height = h;
+    computeWorldShape(t, c, rect);
+
+    const float xy[8] = {-w * 0.5f, -h * 0.5f, w * 0.5f, -h * 0.5f, w * 0.5f, h * 0.5f, -w * 0.5f, h * 0.5f};
+    c.type = ColliderType::Polygon;
+    c.polygon = createPolygon(xy, 4);
+    computeWorldShape(t, c, hull);
+}
+
+// Depth SAT still finds after B is moved by the mtv, 0 when separated
+static float depthAfterPush(const WorldShape& A, WorldShape B, Vec2 mtv) {
+    B.cx += mtv.x; B.cy += mtv.y;
+    B.mx += mtv.x; B.my += mtv.y;
+    for (int i = 0; i < B.count; ++i) {
+        B.vx[i] += mtv.x;
+        B.vy[i] += mtv.y;
+    }
+    Vec2 rest;
+    if (A.count > 0 && B.count > 0) return satShapeShape(A, B, rest) ? len(rest) : 0.0f;
+    return satCircleShape({B.cx, B.cy}, B.radius, A, rest) ? len(rest) : 0.0f;
+}
+
+// Rotated boxes: GJK/EPA on the pool polygons gives the SAT answer. Right at
+// the surface (depth under the tolerance) the two may disagree. SAT measures
+// the interval overlap, which is short of the push when one projection
+// contains the other: depths are compared where the SAT push separates, the
+// GJK push has to separate always
+static void testGjkMatchesSatBoxes() {
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> pos(-40.0f, 40.0f), size(4.0f, 50.0f), angle(0.0f, 360.0f);
+    const float tolerance = 0.02f;
+    int hits = 0;
+
+    for (int n = 0; n < 500; ++n) {
+        WorldShape rectA, hullA, rectB, hullB;
+        rectAndHull(size(rng), size(rng), {0, 0, 0, angle(rng), 1, 1}, rectA, hullA);
+        rectAndHull(size(rng), size(rng), {pos(rng), pos(rng), 0, angle(rng), 1, 1}, rectB, hullB);
+
+        Vec2 sat = {0, 0}, gjk = {0, 0};
+        const bool satHit = satShapeShape(rectA, rectB, sat);
+        const bool gjkHit = gjkShapeShape(hullA, hullB, gjk);
+        if (satHit != gjkHit) {
+            CHECK_MSG(len(satHit ? sat : gjk) < tolerance, "boxes %d: sat %d, gjk %d, depth %g",
+                      n, satHit, gjkHit, len(satHit ? sat : gjk));
+            continue;
+        }
+        if (!satHit) continue;
+        ++hits;
+
+        // same depth; the direction may differ only between axes of equal depth
+        CHECK_MSG(depthAfterPush(rectA, rectB, sat) >= tolerance || nearlyEqual(len(gjk), len(sat), tolerance),
+                  "boxes %d: gjk depth %g, sat %g", n, len(gjk), len(sat));
+        CHECK_MSG(depthAfterPush(rectA, rectB, gjk) < tolerance, "boxes %d: gjk mtv (%g, %g) leaves %g",
+                  n, gjk.x, gjk.y, depthAfterPush(rectA, rectB, gjk));
+    }
+    CHECK_MSG(hits > 100, "only %d overlapping boxes", hits);
+}
+
+// Circle against a rotated box: GJK with the circle's margin against SAT,
+// compared like the boxes
+static void testGjkMatchesSatCircleBox() {
+    std::mt19937 rng(18);
+    std::uniform_real_distribution<float> pos(-50.0f, 50.0f), size(4.0f, 50.0f), angle(0.0f, 360.0f);
+    const float tolerance = 0.02f;
+    int hits = 0;
+
+    for (int n = 0; n < 500; ++n) {
+        WorldShape rect, hull, circle;
+        rectAndHull(size(rng), size(rng), {0, 0, 0, angle(rng), 1, 1}, rect, hull);
+        E_Collider c;
+        c.type = ColliderType::Circle;
+        c.radius = size(rng) * 0.5f;
+        computeWorldShape({pos(rng), pos(rng), 0, 0, 1, 1}, c, circle);
+
+        Vec2 sat = {0, 0}, gjk = {0, 0};
+        const bool satHit = satCircleShape({circle.cx, circle.cy}, circle.radius, rect, sat);
+        const bool gjkHit = gjkShapeShape(hull, circle, gjk);
+        if (satHit != gjkHit) {
+            CHECK_MSG(len(satHit ? sat : gjk) < tolerance, "circle %d: sat %d, gjk %d, depth %g",
+                      n, satHit, gjkHit, len(satHit ? sat : gjk));
+            continue;
+        }
+        if (!satHit) continue;
+        ++hits;
+
+        CHECK_MSG(depthAfterPush(rect, circle, sat) >= tolerance || nearlyEqual(len(gjk), len(sat), tolerance),
+                  "circle %d: gjk depth %g, sat %g", n, len(gjk), len(sat));
+        CHECK_MSG(depthAfterPush(rect, circle, gjk) < tolerance, "circle %d: gjk mtv (%g, %g) leaves %g",
+                  n, gjk.x, gjk.y, depthAfterPush(rect, circle, gjk));
+    }
+    CHECK_MSG(hits > 100, "only %d overlapping circles", hits);
+}
+
+// ================= Time of impact =================
+
+enum class ShapeKind { Circle, Rect, Polygon };
+
+// A collider of the kind with a random size, the polygon is a pool hexagon
+static E_Collider randomCollider(std::mt19937& rng, ShapeKind kind) {
+    std::uniform_real_distribution<float> size(4.0f, 40.0f);
+    E_Collider c;
+    if (kind == ShapeKind::Circle) {
+        c.type = ColliderType::Circle;
+        c.radius = size(rng);
+    } else if (kind == ShapeKind::Rect) {
+        c.type = ColliderType::Rect;
+        c.width = size(rng);
+        c.height = size(rng);
+    } else {
+        static uint32_t hexagon = 0;
+        if (!hexagon) {
+            float xy[12];
+            for (int i = 0; i < 6; ++i) {
+                xy[2 * i] = 18.0f * std::cos(i * 1.0471976f);
+                xy[2 * i + 1] = 11.0f * std::sin(i * 1.0471976f);
+            }
+            hexagon = createPolygon(xy, 6);
+        }
+        c.type = ColliderType::Polygon;
+        c.polygon = hexagon;
+    }
+    return c;
+}
+
+// B moves by d and ends at tB. Sampled first overlap in (0, 1], -1 if none
+static float sampledImpact(const WorldShape& A, E_Transform tB, const E_Collider& cB, Vec2 d, int samples) {
+    WorldShape B;
+    for (int k = 1; k <= samples; ++k) {
+        const float t = (float)k / (float)samples;
+        E_Transform at = tB;
+        at.x += d.x * (t - 1.0f);
+        at.y += d.y * (t - 1.0f);
+        computeWorldShape(at, cB, B);
+        if (shapesOverlap(A, B)) return t;
+    }
+    return -1.0f;
+}
+
+// Every sweep the sampling sees hitting is reported at the first touch
+static void checkImpacts(ShapeKind kindA, ShapeKind kindB, const char* name) {
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> pos(-60.0f, 60.0f), move(-300.0f, 300.0f), angle(0.0f, 360.0f);
+    const int samples = 2000;
+    const float tolerance = 2.0f / samples;
+    int hits = 0;
+
+    for (int n = 0; n < 400; ++n) {
+        const E_Collider cA = randomCollider(rng, kindA);
+        const E_Collider cB = randomCollider(rng, kindB);
+        const E_Transform tA = {0, 0, 0, angle(rng), 1, 1};
+        const E_Transform tB = {pos(rng), pos(rng), 0, angle(rng), 1, 1};
+        const Vec2 d = {move(rng), move(rng)};
+
+        WorldShape A, B, start;
+        computeWorldShape(tA, cA, A);
+        computeWorldShape(tB, cB, B);
+        E_Transform tStart = tB;
+        tStart.x -= d.x;
+        tStart.y -= d.y;
+        computeWorldShape(tStart, cB, start);
+        if (shapesOverlap(A, start)) continue; // reported by the discrete test
+
+        const float expected = sampledImpact(A, tB, cB, d, samples);
+        float t = -1.0f;
+        Vec2 normal = {0, 0};
+        const bool hit = timeOfImpact(A, B, d, t, normal);
+        if (expected < 0.0f) continue; // misses and grazing touches between samples
+        ++hits;
+
+        CHECK_MSG(hit, "%s sweep %d: no impact, sampled at t %g", name, n, expected);
+        if (!hit) continue;
+        CHECK_MSG(t >= 0.0f && t <= expected + tolerance && t >= expected - 2.0f * tolerance,
+                  "%s sweep %d: impact at t %g, sampled at t %g", name, n, t, expected);
+        // the normal points from A to B: B comes in against it
+        CHECK_MSG(nearlyEqual(len(normal), 1.0f, 1e-3f) && dot(normal, d) < 0.0f,
+                  "%s sweep %d: normal (%g, %g)", name, n, normal.x, normal.y);
+    }
+    CHECK_MSG(hits > 50, "%s: only %d sweeps hit", name, hits);
+}
+
+static void testImpactCircleCircle() { checkImpacts(ShapeKind::Circle, ShapeKind::Circle, "circle-circle"); }
+static void testImpactCircleRect() {
+    checkImpacts(ShapeKind::Circle, ShapeKind::Rect, "circle-rect");
+    checkImpacts(ShapeKind::Rect, ShapeKind::Circle, "rect-circle");
+}
+static void testImpactRectRect() { checkImpacts(ShapeKind::Rect, ShapeKind::Rect, "rect-rect"); }
+static void testImpactPolygon() {
+    checkImpacts(ShapeKind::Polygon, ShapeKind::Rect, "polygon-rect");
+    checkImpacts(ShapeKind::Circle, ShapeKind::Polygon, "circle-polygon");
+}
+
+int main() {
+    fprintf(stderr, "simd level: %s\n", simdLevelName());
+
+    const TestCase tests[] = {
+        {"circle-circle kernel: same bits on every simd level", testCircleCircleLevels},
+        {"box-box kernel: same bits on every simd level", testBoxBoxLevels},
+        {"circle-box kernel: same bits on every simd level", testCircleBoxLevels},
+        {"integrator: same bits on every simd level", testIntegrateLevels},
+        {"gjk/epa == sat: rotated boxes", testGjkMatchesSatBoxes},
+        {"gjk/epa == sat: circle against a rotated box", testGjkMatchesSatCircleBox},
+        {"time of impact: circle-circle", testImpactCircleCircle},
+        {"time of impact: circle-rect", testImpactCircleRect},
+        {"time of impact: rect-rect", testImpactRectRect},
+        {"time of impact: polygon (conservative advancement)", testImpactPolygon},
+    };
+    return runTests(tests, sizeof(tests) / sizeof(tests[0]));
+}
@@ -0,0 +1,49 @@
+//
+//  test_common.h rbashkort 16/10/2026
+//
+//  Minimal checks for the test executables (no framework). CHECK counts the
+//  failures and prints where they happened, runTests() runs the cases and
+//  returns the exit code for ctest.
+//
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+
+static int testFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        ++testFailures; \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+// CHECK with a printf message, for checks inside loops over random data
+#define CHECK_MSG(cond, ...) do { \
+    if (!(cond)) { \
+        ++testFailures; \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #cond); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+    } \
+} while (0)
+
+static inline bool nearlyEqual(float a, float b, float eps) { return std::fabs(a - b) <= eps; }
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+static int runTests(const TestCase* tests, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        int before = testFailures;
+        tests[i].run();
+        fprintf(stderr, "[%s] %s\n", testFailures == before ? " ok " : "FAIL", tests[i].name);
+    }
+    if (testFailures) fprintf(stderr, "%d check(s) failed\n", testFailures);
+    return testFailures ? 1 : 0;
+}
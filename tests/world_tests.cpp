@@ -0,0 +1,533 @@
+//
+//  world_tests.cpp rbashkort 16/10/2026
+//
+//  Collision pipeline of a headless ECSWorld against brute force and against
+//  the behaviour the engine promises (pair search, sleeping, bullets,
+//  triggers, tile maps, scene queries). No window or GL context.
+//
+
+#include "test_common.h"
+#include "ecs_world.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+using IdPair = std::pair<flecs::entity_t, flecs::entity_t>;
+
+struct Body {
+    flecs::entity e;
+    float x, y, r;
+    int layer;
+};
+
+static void initWorld(ECSWorld& ecs, BroadphaseMode mode = BroadphaseMode::Grid, unsigned threads = 4) {
+    ecs.init(true);
+    ecs.setBroadphaseMode(mode);
+    ecs.setPhysicsThreads(threads);
+}
+
+// One fixed physics step
+static void step(ECSWorld& ecs, int steps = 1) {
+    for (int i = 0; i < steps; ++i) ecs.update(ecs.getFixedDeltaTime());
+}
+
+static flecs::entity addCircle(ECSWorld& ecs, float x, float y, float r, int layer = 1) {
+    E_Collider c;
+    c.type = ColliderType::Circle;
+    c.radius = r;
+    c.layer = layer;
+    return ecs.getWorld().entity()
+        .set<E_Transform>({x, y, 0, 0, 1, 1})
+        .set<E_Collider>(c);
+}
+
+static flecs::entity addRect(ECSWorld& ecs, float x, float y, float w, float h, bool isStatic) {
+    E_Collider c;
+    c.type = ColliderType::Rect;
+    c.width = w;
+    c.height = h;
+    c.isStatic = isStatic;
+    return ecs.getWorld().entity()
+        .set<E_Transform>({x, y, 0, 0, 1, 1})
+        .set<E_Collider>(c);
+}
+
+static IdPair idPair(flecs::entity_t a, flecs::entity_t b) {
+    return a < b ? IdPair{a, b} : IdPair{b, a};
+}
+
+// Entity pairs of the contacts of the last update()
+static std::vector<IdPair> contactPairs(const ECSWorld& ecs) {
+    std::vector<IdPair> pairs;
+    for (const E_CollisionEvent& ev : ecs.collisionEvents()) pairs.push_back(idPair(ev.a.id(), ev.b.id()));
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+// Resting circles (no E_Velocity): the broadphase boxes are the circle boxes.
+// candidatePairs must be the box-overlapping pairs exactly (a missed or doubled
+// pair changes the count), the contacts the overlapping circles
+static void checkPairsAgainstBruteForce(ECSWorld& ecs, const std::vector<Body>& bodies, const char* what) {
+    step(ecs);
+
+    uint64_t boxPairs = 0;
+    std::vector<IdPair> mustTouch, mayTouch;
+    for (size_t i = 0; i < bodies.size(); ++i)
+    for (size_t j = i + 1; j < bodies.size(); ++j) {
+        const Body& a = bodies[i];
+        const Body& b = bodies[j];
+        E_Collider ca, cb;
+        ca.layer = a.layer;
+        cb.layer = b.layer;
+        if (!ecs.canCollide(ca, cb)) continue;
+
+        const Aabb boxA = {a.x - a.r, a.y - a.r, a.x + a.r, a.y + a.r};
+        const Aabb boxB = {b.x - b.r, b.y - b.r, b.x + b.r, b.y + b.r};
+        if (!boxA.overlaps(boxB)) continue;
+        ++boxPairs;
+
+        const float d = std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+        if (d < a.r + b.r + 1e-3f) mayTouch.push_back(idPair(a.e.id(), b.e.id()));
+        if (d < a.r + b.r - 1e-3f) mustTouch.push_back(idPair(a.e.id(), b.e.id()));
+    }
+    std::sort(mustTouch.begin(), mustTouch.end());
+    std::sort(mayTouch.begin(), mayTouch.end());
+
+    const PhysicsStats& stats = ecs.getPhysicsStats();
+    CHECK_MSG(stats.candidatePairs == boxPairs, "%s: %llu candidate pairs, brute force %llu", what,
+              (unsigned long long)stats.candidatePairs, (unsigned long long)boxPairs);
+
+    std::vector<IdPair> contacts = contactPairs(ecs);
+    CHECK_MSG(std::includes(contacts.begin(), contacts.end(), mustTouch.begin(), mustTouch.end()),
+              "%s: an overlapping pair has no contact", what);
+    CHECK_MSG(std::includes(mayTouch.begin(), mayTouch.end(), contacts.begin(), contacts.end()),
+              "%s: a contact between separated circles", what);
+}
+
+// ================= Grid pair search =================
+
+// Every overlapping pair is reported by the one cell holding the min corner of
+// the overlap. Many bodies sit exactly on cell borders (multiples of 128)
+static void testGridPairOwnership() {
+    ECSWorld ecs;
+    initWorld(ecs);
+
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<float> pos(-1000.0f, 1000.0f);
+    std::uniform_int_distribution<int> border(-8, 8);
+    std::vector<Body> bodies;
+    for (int i = 0; i < 3000; ++i) {
+        float x = pos(rng), y = pos(rng);
+        if (i % 4 == 0) x = border(rng) * 128.0f;
+        if (i % 6 == 0) y = border(rng) * 128.0f;
+        const float r = 5.0f + (float)(i % 8);
+        bodies.push_back({addCircle(ecs, x, y, r), x, y, r, 1});
+    }
+
+    checkPairsAgainstBruteForce(ecs, bodies, "grid");
+    CHECK(ecs.getPhysicsStats().duplicatePairs > 0); // border bodies share cells
+}
+
+// Bodies from 2 to 3000 units (every grid level) on four layers, layer 2
+// ignores 3 and itself. Pairs across levels and layers == brute force in every
+// broadphase mode (the tree's fat leaves must not leak into candidatePairs),
+// and all modes find the same contacts
+static void testGridLevelsAndLayers() {
+    std::vector<IdPair> contacts[3];
+    const BroadphaseMode modes[3] = {BroadphaseMode::Grid, BroadphaseMode::SweepAndPrune, BroadphaseMode::AabbTree};
+    const char* names[3] = {"grid levels", "sap layers", "tree layers"};
+    for (int m = 0; m < 3; ++m) {
+        ECSWorld ecs;
+        initWorld(ecs, modes[m]);
+        ecs.setLayerCollision(2, 3, false);
+        ecs.setLayerCollision(2, 2, false);
+
+        std::mt19937 rng(21);
+        std::uniform_real_distribution<float> pos(-4000.0f, 4000.0f), unit(0.0f, 1.0f);
+        std::vector<Body> bodies;
+        for (int i = 0; i < 2000; ++i) {
+            const float x = pos(rng), y = pos(rng);
+            const float r = 2.0f * std::pow(1500.0f, unit(rng) * unit(rng)); // mostly small
+            const int layer = 1 + i % 4;
+            bodies.push_back({addCircle(ecs, x, y, r, layer), x, y, r, layer});
+        }
+
+        checkPairsAgainstBruteForce(ecs, bodies, names[m]);
+        if (modes[m] == BroadphaseMode::Grid) {
+            const PhysicsStats& stats = ecs.getPhysicsStats();
+            int levels = 0;
+            for (uint32_t cells : stats.cellsPerLevel) levels += cells > 0;
+            CHECK_MSG(levels >= 4, "bodies on %d grid levels", levels);
+        }
+        contacts[m] = contactPairs(ecs);
+    }
+    CHECK_MSG(contacts[0] == contacts[1], "grid %zu contacts, sweep and prune %zu", contacts[0].size(), contacts[1].size());
+    CHECK_MSG(contacts[0] == contacts[2], "grid %zu contacts, aabb tree %zu", contacts[0].size(), contacts[2].size());
+}
+
+// ================= Threads =================
+
+struct Recording {
+    std::vector<E_CollisionEvent> events;   // every step, in order, as reported
+    std::vector<E_Transform> poses;
+};
+
+// Crowded moving circles and boxes, some rotated, a few static walls. Mixed
+// circle/box pairs go through the flipped kernel path, so a swapped pair
+// changes the MTV sign and the event orientation
+static Recording runCrowd(BroadphaseMode mode, unsigned threads) {
+    ECSWorld ecs;
+    initWorld(ecs, mode, threads);
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> pos(-600.0f, 600.0f), vel(-200.0f, 200.0f), size(4.0f, 20.0f);
+    std::vector<flecs::entity> bodies;
+    for (int i = 0; i < 1500; ++i) {
+        const float x = pos(rng), y = pos(rng);
+        flecs::entity e = i % 2 ? addRect(ecs, x, y, size(rng), size(rng), false) : addCircle(ecs, x, y, size(rng) * 0.5f);
+        if (i % 7 == 0) e.get_mut<E_Transform>().angle = 0.5f;
+        e.set<E_Velocity>({vel(rng), vel(rng)});
+        bodies.push_back(e);
+    }
+    addRect(ecs, 0, 650, 1400, 40, true);
+    addRect(ecs, 0, -650, 1400, 40, true);
+
+    Recording rec;
+    for (int i = 0; i < 30; ++i) {
+        step(ecs);
+        for (const E_CollisionEvent& ev : ecs.collisionEvents()) rec.events.push_back(ev);
+    }
+    for (flecs::entity e : bodies) rec.poses.push_back(e.get<E_Transform>());
+    return rec;
+}
+
+// 1 and 4 worker threads give the same events, same orientation, and bit-equal poses
+static void testThreadCountDeterminism() {
+    const BroadphaseMode modes[3] = {BroadphaseMode::Grid, BroadphaseMode::SweepAndPrune, BroadphaseMode::AabbTree};
+    for (BroadphaseMode mode : modes) {
+        const Recording one = runCrowd(mode, 1);
+        const Recording four = runCrowd(mode, 4);
+        CHECK(!one.events.empty());
+
+        CHECK_MSG(one.events.size() == four.events.size(), "mode %d: %zu events with 1 thread, %zu with 4",
+                  (int)mode, one.events.size(), four.events.size());
+        for (size_t i = 0; i < std::min(one.events.size(), four.events.size()); ++i) {
+            const E_CollisionEvent& x = one.events[i];
+            const E_CollisionEvent& y = four.events[i];
+            if (x.a.id() == y.a.id() && x.b.id() == y.b.id() && x.isTrigger == y.isTrigger) continue;
+            CHECK_MSG(false, "mode %d: event %zu is (%llu, %llu) with 1 thread, (%llu, %llu) with 4", (int)mode, i,
+                      (unsigned long long)x.a.id(), (unsigned long long)x.b.id(),
+                      (unsigned long long)y.a.id(), (unsigned long long)y.b.id());
+            break;
+        }
+
+        for (size_t i = 0; i < one.poses.size(); ++i) {
+            const E_Transform& p = one.poses[i];
+            const E_Transform& q = four.poses[i];
+            if (p.x == q.x && p.y == q.y && p.angle == q.angle) continue;
+            CHECK_MSG(false, "mode %d: body %zu at (%g, %g) with 1 thread, (%g, %g) with 4",
+                      (int)mode, i, p.x, p.y, q.x, q.y);
+            break;
+        }
+    }
+}
+
+// ================= Sleeping =================
+
+// 0.5 s to fall asleep, a few steps more for the deferred E_Sleep
+static const int STEPS_TO_SLEEP = 45;
+
+// A stopped body sleeps, a get_mut velocity write (no OnSet) wakes it
+static void testSleepWakesOnGetMutVelocity() {
+    ECSWorld ecs;
+    initWorld(ecs);
+    flecs::entity e = addCircle(ecs, 0, 0, 10).set<E_Velocity>({0, 0});
+
+    step(ecs, STEPS_TO_SLEEP);
+    CHECK(e.has<E_Asleep>());
+
+    e.get_mut<E_Velocity>().vx = 120.0f;
+    step(ecs);
+    CHECK(!e.has<E_Asleep>());
+    step(ecs, 10);
+    CHECK_MSG(e.get<E_Transform>().x > 10.0f, "woken body at x %g", e.get<E_Transform>().x);
+}
+
+// Moving a sleeper through get_mut<E_Transform> wakes it at the new place
+static void testSleepWakesOnGetMutTransform() {
+    ECSWorld ecs;
+    initWorld(ecs);
+    flecs::entity e = addCircle(ecs, 0, 0, 10).set<E_Velocity>({0, 0});
+    flecs::entity other = addCircle(ecs, 300, 0, 10).set<E_Velocity>({0, 0});
+
+    step(ecs, STEPS_TO_SLEEP);
+    CHECK(e.has<E_Asleep>() && other.has<E_Asleep>());
+
+    e.get_mut<E_Transform>().x = 295.0f; // into the other circle
+    step(ecs);
+    CHECK(!e.has<E_Asleep>());
+    CHECK(!other.has<E_Asleep>()); // woken by the contact
+}
+
+// Slow free bodies keep drifting, a body resting on a floor falls asleep
+static void testSleepIdleRule() {
+    ECSWorld ecs;
+    initWorld(ecs);
+    flecs::entity drifter = addCircle(ecs, -500, 0, 10).set<E_Velocity>({1.0f, 0});
+
+    addRect(ecs, 0, 100, 400, 20, true);
+    flecs::entity box = addRect(ecs, 0, 60, 20, 20, false)
+        .set<E_Velocity>({0, 0})
+        .set<E_Gravity>({500.0f, true});
+
+    step(ecs, 240);
+    CHECK(!drifter.has<E_Asleep>());
+    CHECK_MSG(nearlyEqual(drifter.get<E_Transform>().x, -496.0f, 0.05f), "drifter at x %g",
+              drifter.get<E_Transform>().x);
+    CHECK(box.has<E_Asleep>());
+    CHECK_MSG(nearlyEqual(box.get<E_Transform>().y, 80.0f, 1.0f), "box rests at y %g", box.get<E_Transform>().y);
+}
+
+// ================= Bullets =================
+
+// A bullet crossing a thin wall in one step ends overlapping a box behind it.
+// It is moved back to the wall, the box contact found at the end pose is stale
+static void testBulletDropsEndPoseContacts() {
+    ECSWorld ecs;
+    initWorld(ecs);
+    flecs::entity wall = addRect(ecs, 50, 0, 4, 200, true);
+    flecs::entity box = addRect(ecs, 100, 0, 20, 20, true);
+
+    E_Collider c;
+    c.type = ColliderType::Circle;
+    c.radius = 4.0f;
+    c.isBullet = true;
+    flecs::entity bullet = ecs.getWorld().entity()
+        .set<E_Transform>({0, 0, 0, 0, 1, 1})
+        .set<E_Collider>(c)
+        .set<E_Velocity>({6000.0f, 0}); // 100 px per step: 0 -> 100
+
+    step(ecs);
+    const float x = bullet.get<E_Transform>().x;
+    CHECK_MSG(x < 48.0f && x > 40.0f, "bullet at x %g, the wall face is at 44", x);
+    std::vector<IdPair> contacts = contactPairs(ecs);
+    CHECK(std::binary_search(contacts.begin(), contacts.end(), idPair(bullet.id(), wall.id())));
+    CHECK(!std::binary_search(contacts.begin(), contacts.end(), idPair(bullet.id(), box.id())));
+    CHECK(bullet.get<E_Velocity>().vx <= 0.0f);
+}
+
+// ================= Triggers =================
+
+struct TriggerLog {
+    int enters = 0, exits = 0;
+    int enterStep = -1, exitStep = -1;
+};
+
+// Steps and records the events of one trigger/body pair
+static TriggerLog stepTriggers(ECSWorld& ecs, int steps, flecs::entity trigger, flecs::entity other) {
+    TriggerLog log;
+    for (int i = 0; i < steps; ++i) {
+        step(ecs);
+        for (const E_TriggerEvent& ev : ecs.triggerEvents()) {
+            CHECK(ev.trigger == trigger && ev.other == other);
+            if (ev.entered) { ++log.enters; log.enterStep = i; }
+            else { ++log.exits; log.exitStep = i; }
+        }
+    }
+    return log;
+}
+
+static flecs::entity addZone(ECSWorld& ecs, float x, float y, float w, float h) {
+    E_Collider c;
+    c.type = ColliderType::Rect;
+    c.width = w;
+    c.height = h;
+    c.isStatic = true;
+    c.isTrigger = true;
+    return ecs.getWorld().entity()
+        .set<E_Transform>({x, y, 0, 0, 1, 1})
+        .set<E_Collider>(c);
+}
+
+// A body crossing a static zone: one enter, one exit, no push
+static void testTriggerEnterExit() {
+    ECSWorld ecs;
+    initWorld(ecs);
+    flecs::entity zone = addZone(ecs, 200, 0, 100, 100); // x 150..250
+    flecs::entity ball = addCircle(ecs, 0, 0, 10).set<E_Velocity>({600.0f, 0}); // 10 px per step
+
+    TriggerLog log = stepTriggers(ecs, 40, zone, ball);
+    CHECK_MSG(log.enters == 1 && log.exits == 1, "%d enters, %d exits", log.enters, log.exits);
+    CHECK_MSG(log.enterStep >= 12 && log.enterStep <= 14, "entered at step %d", log.enterStep);
+    CHECK_MSG(log.exitStep >= 25 && log.exitStep <= 27, "left at step %d", log.exitStep);
+    CHECK_MSG(nearlyEqual(ball.get<E_Transform>().x, 400.0f, 0.5f), "ball at x %g", ball.get<E_Transform>().x);
+}
+
+// A body that falls asleep inside a static zone stays inside (no exit while
+// the pair is not tested), leaving after a wake gives the exit
+static void testTriggerSleeperStaysInside() {
+    ECSWorld ecs;
+    initWorld(ecs);
+    flecs::entity zone = addZone(ecs, 0, 0, 100, 100);
+    flecs::entity ball = addCircle(ecs, 0, 0, 10).set<E_Velocity>({0, 0});
+
+    TriggerLog log = stepTriggers(ecs, STEPS_TO_SLEEP + 20, zone, ball);
+    CHECK(ball.has<E_Asleep>());
+    CHECK_MSG(log.enters == 1 && log.exits == 0, "%d enters, %d exits", log.enters, log.exits);
+
+    ball.get_mut<E_Velocity>().vx = 600.0f;
+    log = stepTriggers(ecs, 15, zone, ball);
+    CHECK_MSG(log.enters == 0 && log.exits == 1, "after the wake: %d enters, %d exits", log.enters, log.exits);
+}
+
+// ================= Tile maps =================
+
+static flecs::entity addTileMap(ECSWorld& ecs, int width, int height, int chunkSize, const std::vector<uint8_t>& solid) {
+    E_TileMap map;
+    map.width = width;
+    map.height = height;
+    map.chunkSize = chunkSize;
+    map.solid = solid;
+    return ecs.getWorld().entity()
+        .set<E_Transform>({0, 0, 0, 0, 1, 1})
+        .set<E_TileMap>(map);
+}
+
+// Every tile center hits the map exactly when the tile is solid
+static void checkTiles(ECSWorld& ecs, flecs::entity map, const char* what) {
+    const E_TileMap& m = map.get<E_TileMap>();
+    std::vector<flecs::entity_t> found;
+    int wrong = 0;
+    for (int y = 0; y < m.height; ++y)
+    for (int x = 0; x < m.width; ++x) {
+        found.clear();
+        ecs.overlapRect((x + 0.5f) * m.tileSize, (y + 0.5f) * m.tileSize, m.tileSize * 0.25f, m.tileSize * 0.25f, 0, found);
+        const bool hit = std::find(found.begin(), found.end(), map.id()) != found.end();
+        wrong += hit != (m.solid[(size_t)y * m.width + x] != 0);
+    }
+    CHECK_MSG(wrong == 0, "%s: %d tiles answer wrong", what, wrong);
+}
+
+// A full chunk is one rect, a random map is covered exactly and with fewer
+// rects than tiles, setTile rebuilds the chunk
+static void testTileGreedyMeshing() {
+    {
+        ECSWorld ecs;
+        initWorld(ecs);
+        addTileMap(ecs, 64, 64, 32, std::vector<uint8_t>(64 * 64, 1));
+        step(ecs);
+        CHECK_MSG(ecs.getPhysicsStats().staticBodies == 4, "full 2x2 chunks: %u rects",
+                  ecs.getPhysicsStats().staticBodies);
+    }
+
+    ECSWorld ecs;
+    initWorld(ecs);
+    std::mt19937 rng(19);
+    const int width = 50, height = 40;
+    std::vector<uint8_t> solid((size_t)width * height);
+    int solidTiles = 0;
+    for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x) {
+        // solid blocks with random holes, like a level
+        const bool block = ((x / 7) + (y / 5)) % 2 == 0;
+        solid[(size_t)y * width + x] = block ? rng() % 10 != 0 : rng() % 10 == 0;
+        solidTiles += solid[(size_t)y * width + x];
+    }
+    flecs::entity map = addTileMap(ecs, width, height, 16, solid);
+    step(ecs);
+    const uint32_t rects = ecs.getPhysicsStats().staticBodies;
+    CHECK_MSG(rects > 0 && (int)rects * 3 < solidTiles, "%u rects for %d solid tiles", rects, solidTiles);
+    checkTiles(ecs, map, "random map");
+
+    ecs.setTile(map, 10, 3, !solid[3 * width + 10]);
+    ecs.setTile(map, 33, 20, !solid[20 * width + 33]);
+    ecs.setTile(map, 49, 39, !solid[39 * width + 49]);
+    step(ecs);
+    checkTiles(ecs, map, "after setTile");
+}
+
+// ================= Scene queries =================
+
+// Circles of every grid level, moving ones for all modes. Rays also start far
+// outside the bodies (the grid clips them to the occupied bounds)
+static void checkQueries(BroadphaseMode mode, const char* what) {
+    ECSWorld ecs;
+    initWorld(ecs, mode);
+
+    std::mt19937 rng(15);
+    std::uniform_real_distribution<float> pos(-1500.0f, 1500.0f), size(3.0f, 30.0f), far(-20000.0f, 20000.0f);
+    std::vector<Body> bodies;
+    for (int i = 0; i < 800; ++i) {
+        const float x = pos(rng), y = pos(rng);
+        const float r = i % 100 == 0 ? 300.0f : size(rng);
+        bodies.push_back({addCircle(ecs, x, y, r), x, y, r, 1});
+    }
+    step(ecs);
+
+    std::uniform_real_distribution<float> queryRadius(0.0f, 200.0f);
+    for (int q = 0; q < 300; ++q) {
+        const float x = pos(rng), y = pos(rng), r = queryRadius(rng);
+        std::vector<flecs::entity_t> found, mustHit, mayHit;
+        ecs.overlapCircle(x, y, r, found);
+        std::sort(found.begin(), found.end());
+        for (const Body& b : bodies) {
+            const float d = std::sqrt((b.x - x) * (b.x - x) + (b.y - y) * (b.y - y));
+            if (d < b.r + r + 1e-3f) mayHit.push_back(b.e.id());
+            if (d < b.r + r - 1e-3f) mustHit.push_back(b.e.id());
+        }
+        std::sort(mustHit.begin(), mustHit.end());
+        std::sort(mayHit.begin(), mayHit.end());
+        CHECK_MSG(std::includes(found.begin(), found.end(), mustHit.begin(), mustHit.end()) &&
+                  std::includes(mayHit.begin(), mayHit.end(), found.begin(), found.end()),
+                  "%s overlap %d: %zu found, %zu expected", what, q, found.size(), mustHit.size());
+
+        // closest circle entered by the segment, bodies it starts in are skipped
+        const float x0 = q % 3 ? pos(rng) : far(rng), y0 = q % 3 ? pos(rng) : far(rng);
+        const float x1 = far(rng), y1 = far(rng);
+        const float dx = x1 - x0, dy = y1 - y0;
+        flecs::entity_t best = 0;
+        float bestT = 2.0f;
+        for (const Body& b : bodies) {
+            const float mx = x0 - b.x, my = y0 - b.y;
+            const float a = dx * dx + dy * dy, half = mx * dx + my * dy, c = mx * mx + my * my - b.r * b.r;
+            const float disc = half * half - a * c;
+            if (c < 0.0f || disc < 0.0f) continue;
+            const float t = (-half - std::sqrt(disc)) / a;
+            if (t >= 0.0f && t <= 1.0f && t < bestT) {
+                bestT = t;
+                best = b.e.id();
+            }
+        }
+        RayHit hit;
+        const bool hitSomething = ecs.raycast(x0, y0, x1, y1, hit);
+        CHECK_MSG(hitSomething == (best != 0) && (hit.entity == best || nearlyEqual(hit.fraction, bestT, 1e-4f)),
+                  "%s ray %d: hit %llu at %g, brute force %llu at %g", what, q,
+                  (unsigned long long)hit.entity, hit.fraction, (unsigned long long)best, bestT);
+    }
+}
+
+static void testQueriesGrid() { checkQueries(BroadphaseMode::Grid, "grid"); }
+static void testQueriesSweepAndPrune() { checkQueries(BroadphaseMode::SweepAndPrune, "sap"); }
+static void testQueriesAabbTree() { checkQueries(BroadphaseMode::AabbTree, "tree"); }
+
+int main() {
+    const TestCase tests[] = {
+        {"grid pairs: min-corner ownership == brute force", testGridPairOwnership},
+        {"pairs: levels and layers == brute force in all modes, same contacts", testGridLevelsAndLayers},
+        {"threads: 1 and 4 threads give the same events and poses", testThreadCountDeterminism},
+        {"sleep: get_mut velocity write wakes", testSleepWakesOnGetMutVelocity},
+        {"sleep: get_mut transform write wakes", testSleepWakesOnGetMutTransform},
+        {"sleep: slow drift stays awake, resting box sleeps", testSleepIdleRule},
+        {"bullet: end pose contacts dropped after the rewind", testBulletDropsEndPoseContacts},
+        {"trigger: one enter and one exit per crossing", testTriggerEnterExit},
+        {"trigger: a sleeper stays inside a static zone", testTriggerSleeperStaysInside},
+        {"tile map: greedy rects cover exactly the solid tiles", testTileGreedyMeshing},
+        {"queries: grid overlap and raycast == brute force", testQueriesGrid},
+        {"queries: sweep and prune overlap and raycast == brute force", testQueriesSweepAndPrune},
+        {"queries: aabb tree overlap and raycast == brute force", testQueriesAabbTree},
+    };
+    return runTests(tests, sizeof(tests) / sizeof(tests[0]));
+}